@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 /* A block device. */
 struct block
@@ -121,8 +122,10 @@ void
 block_read (struct block *block, block_sector_t sector, void *buffer)
 {
   check_sector (block, sector);
+  trace_point (TRACE_BLOCK_READ_ENTER, block->type, sector, 0);
   block->ops->read (block->aux, sector, buffer);
   block->read_cnt++;
+  trace_point (TRACE_BLOCK_READ_EXIT, block->type, sector, 0);
 }
 
 /* Write sector SECTOR to BLOCK from BUFFER, which must contain
@@ -135,8 +138,10 @@ block_write (struct block *block, block_sector_t sector, const void *buffer)
 {
   check_sector (block, sector);
   ASSERT (block->type != BLOCK_FOREIGN);
+  trace_point (TRACE_BLOCK_WRITE_ENTER, block->type, sector, 0);
   block->ops->write (block->aux, sector, buffer);
   block->write_cnt++;
+  trace_point (TRACE_BLOCK_WRITE_EXIT, block->type, sector, 0);
 }
 
 /* Returns the number of sectors in BLOCK. */
@@ -5,8 +5,10 @@
 #include <stdio.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/tsc.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -23,10 +25,88 @@ static int64_t ticks;
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
-/* Threads waiting in timer_sleep(). */
-static struct list wait_list;
+/* Threads waiting in timer_sleep() are kept in a hierarchical
+   timing wheel.  Level 0 has one slot per tick for the next
+   WHEEL_SLOTS ticks; each slot of level L covers WHEEL_SLOTS
+   times as many ticks as a slot of level L - 1.  A sleeper goes
+   straight into the slot for its wake-up time at the lowest
+   level that reaches that far, so inserting takes constant
+   time.  Whenever level L - 1 wraps around, the next slot of
+   level L is "cascaded": its threads are moved down to finer
+   slots.  Each sleeper is moved at most once per level, so
+   expiry is amortized constant time per sleeper.  Wake-up times
+   beyond the top level are parked in its farthest slot and
+   cascaded again until they come within reach.
+
+   The timer interrupt only counts the tick.  Cascading and waking
+   sleepers happen in the timer softirq, with interrupts on, which
+   brings the wheel up to date with `ticks' one thread at a time. */
+#define WHEEL_BITS 6                            /* log2(WHEEL_SLOTS). */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)           /* Slots per level. */
+#define WHEEL_LEVELS 4                          /* Number of levels. */
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static int64_t wheel_time;      /* Last tick the wheel processed. */
+
+/* Sleep queue statistics. */
+static unsigned sleeper_cnt;            /* Threads now asleep. */
+static unsigned sleeper_peak;           /* Most threads ever asleep. */
+static uint64_t insert_max_cycles;      /* Longest insert, interrupts off. */
+static uint64_t expire_max_cycles;      /* Longest timer softirq run. */
+
+/* One-shot mode.  Normally the PIT interrupts once per tick.
+   When something must happen between ticks, or (with kernel
+   command-line option "-tickless") the idle thread could skip
+   some ticks, the PIT is instead programmed for a single
+   interrupt at the next interesting moment.  While in one-shot
+   mode, time is kept by the TSC, calibrated against the PIT by
+   timer_calibrate(): every external interrupt replays the ticks
+   that went by since the last one, wakes expired high-resolution
+   sleepers, and reprograms the PIT.  The periodic interrupt is
+   restored at a tick boundary once nothing is pending. */
+bool timer_tickless;
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ) /* PIT cycles per tick. */
+#define IDLE_MAX_TICKS (65536 / TICK_CYCLES)    /* Longest one-shot. */
+static uint64_t tsc_per_tick;   /* TSC cycles per tick, 0 if uncalibrated. */
+static uint64_t last_tick_tsc;  /* TSC at the last whole tick. */
+static bool one_shot;           /* PIT in one-shot mode? */
+static bool intr_one_shot;      /* Was it, when this interrupt began? */
+static long long idle_periods;  /* # of tickless idle periods. */
+static long long idle_skipped;  /* Timer interrupts avoided. */
+
+/* Sleeps shorter than a tick block on a list ordered by TSC
+   deadline, woken by a one-shot PIT interrupt.  Sleeps shorter
+   than HR_SLEEP_MIN_NS still busy-wait, because blocking and
+   reprogramming the PIT would take about as long. */
+#define HR_SLEEP_MIN_NS 5000
+static struct list hr_list;     /* Sub-tick sleepers, soonest first. */
+static long long hr_sleeps;     /* # of sub-tick sleeps that blocked. */
+static uint64_t hr_late_max;    /* Latest wake-up, in TSC cycles. */
+
 static intr_handler_func timer_interrupt;
 
+static softirq_func timer_softirq;
+
+static void timer_tick(void);
+
+static int ticks_until_event(int max);
+
+static void hr_sleep(uint64_t cycles);
+
+static void hr_expire(uint64_t now);
+
+static bool hr_less(const struct list_elem *, const struct list_elem *,
+                    void *aux);
+
+static void timer_program(uint64_t deadline, uint64_t now);
+
+static void timer_reprogram(uint64_t now);
+
+static void wheel_insert(struct thread *);
+
+static struct thread *wheel_next(void);
+
+static void wheel_cascade(int level);
+
 static bool too_many_loops(unsigned loops);
 
 static void busy_wait(int64_t loops);
@@ -39,9 +119,15 @@ static void real_time_delay(int64_t num, int32_t denom);
    and registers the corresponding interrupt. */
 void
 timer_init(void) {
+    int level, slot;
+
     pit_configure_channel(0, 2, TIMER_FREQ);
     intr_register_ext(0x20, timer_interrupt, "8254 Timer");
-    list_init(&wait_list);
+    intr_register_softirq(SOFTIRQ_TIMER, timer_softirq, "timer");
+    for (level = 0; level < WHEEL_LEVELS; level++)
+        for (slot = 0; slot < WHEEL_SLOTS; slot++)
+            list_init(&wheel[level][slot]);
+    list_init(&hr_list);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -69,6 +155,25 @@ timer_calibrate(void) {
     printf("%'"
     PRIu64
     " loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+    /* Count TSC cycles across a few whole ticks, for one-shot
+       mode. */
+    {
+        int64_t start = ticks;
+        uint64_t tsc;
+
+        while (ticks == start)
+            barrier();
+        tsc = rdtsc();
+        start = ticks;
+        while (ticks < start + 10)
+            barrier();
+        tsc = (rdtsc() - tsc) / 10;
+
+        intr_disable();
+        tsc_per_tick = tsc;
+        intr_enable();
+    }
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -87,34 +192,34 @@ timer_elapsed(int64_t then) {
     return timer_ticks() - then;
 }
 
-/* Compares two threads based on their wake-up times. */
-static bool
-compare_threads_by_wakeup_time(const struct list_elem *a_,
-                               const struct list_elem *b_,
-                               void *aux UNUSED) {
-    const struct thread *a = list_entry(a_,
-    struct thread, timer_elem);
-    const struct thread *b = list_entry(b_,
-    struct thread, timer_elem);
-
-    return a->wakeup_time < b->wakeup_time;
+/* Returns the number of TSC cycles per timer tick, or 0 if
+   timer_calibrate() has not run yet. */
+uint64_t
+timer_tsc_per_tick(void) {
+    return tsc_per_tick;
 }
 
-
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void
 timer_sleep(int64_t ticks) {
     struct thread *t = thread_current();
+    uint64_t start, cycles;
 
-    /* Schedule our wake-up time. */
-    t->wakeup_time = timer_ticks() + ticks;
-
-    /* Atomically insert the current thread into the wait list. */
     ASSERT(intr_get_level() == INTR_ON);
+    if (ticks <= 0)
+        return;
+
+    /* Atomically schedule our wake-up time. */
     intr_disable();
-    list_insert_ordered(&wait_list, &t->timer_elem,
-                        compare_threads_by_wakeup_time, NULL);
+    start = rdtsc();
+    t->wakeup_time = ticks + timer_ticks();
+    wheel_insert(t);
+    if (++sleeper_cnt > sleeper_peak)
+        sleeper_peak = sleeper_cnt;
+    cycles = rdtsc() - start;
+    if (cycles > insert_max_cycles)
+        insert_max_cycles = cycles;
     intr_enable();
 
     /* Wait. */
@@ -184,21 +289,300 @@ timer_print_stats(void) {
     printf("Timer: %"
     PRId64
     " ticks\n", timer_ticks());
+    printf("Timer: %u sleepers peak, longest interrupts-off window "
+           "%"PRIu64" cycles to insert, %"PRIu64" cycles per tick\n",
+           sleeper_peak, insert_max_cycles, expire_max_cycles);
+    if (timer_tickless)
+        printf("Timer: %lld tickless idle periods, %lld interrupts avoided\n",
+               idle_periods, idle_skipped);
+    if (hr_sleeps > 0)
+        printf("Timer: %lld sub-tick sleeps, latest wake-up %"PRIu64" ns late\n",
+               hr_sleeps, hr_late_max * (1000 * 1000 * 1000 / TIMER_FREQ)
+                          / tsc_per_tick);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, stops the periodic timer interrupt
+   until the next tick that has work to do, or the next sub-tick
+   sleeper's deadline if that is sooner. */
+void
+timer_idle_enter(void) {
+    uint64_t deadline;
+    int n;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!timer_tickless || tsc_per_tick == 0)
+        return;
+
+    /* Expiry still pending in the softirq means the wheel cannot
+       tell when the next sleeper is due. */
+    if (wheel_time != ticks)
+        return;
+    n = ticks_until_event(IDLE_MAX_TICKS);
+    if (n < 2)
+        return;
+
+    deadline = last_tick_tsc + n * tsc_per_tick;
+    if (!list_empty(&hr_list)) {
+        struct thread *t = list_entry(list_front(&hr_list),
+                                      struct thread, timer_elem);
+        if (t->wakeup_tsc < deadline)
+            deadline = t->wakeup_tsc;
+    }
+    timer_program(deadline, rdtsc());
+    idle_periods++;
+}
+
+/* Called at the start of every external interrupt.  In one-shot
+   mode, replays the ticks that went by since the last interrupt,
+   wakes expired sub-tick sleepers, and reprograms the PIT. */
+void
+timer_intr_enter(void) {
+    uint64_t now;
+    int elapsed = 0;
+
+    ASSERT(intr_context());
+
+    intr_one_shot = one_shot;
+    if (!one_shot)
+        return;
+
+    now = rdtsc();
+    while (now - last_tick_tsc >= tsc_per_tick) {
+        last_tick_tsc += tsc_per_tick;
+        timer_tick();
+        elapsed++;
+    }
+    if (elapsed > 1)
+        idle_skipped += elapsed - 1;
+    hr_expire(now);
+    timer_reprogram(now);
+}
+
+/* Returns how many ticks from now the next tick on which a
+   sleeper may wake or a real-time period begins is, or MAX if
+   none is that close.  Interrupts must be off. */
+static int
+ticks_until_event(int max) {
+    int64_t release = thread_next_release() - ticks;
+    int d;
+
+    for (d = 1; d < max; d++) {
+        int64_t t = ticks + d;
+
+        /* Cascading may make a sleeper due on a wrap of level 0. */
+        if (!list_empty(&wheel[0][t & (WHEEL_SLOTS - 1)])
+            || (t & (WHEEL_SLOTS - 1)) == 0 || d >= release)
+            break;
+    }
+    return d;
 }
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt(struct intr_frame *args UNUSED) {
+timer_interrupt(struct intr_frame *args) {
+    if (profile_enabled)
+        profile_sample(args);
+
+    /* In one-shot mode timer_intr_enter() did all the work. */
+    if (intr_one_shot)
+        return;
+    last_tick_tsc = rdtsc();
+    timer_tick();
+}
+
+/* Blocks the current thread for CYCLES TSC cycles, which should
+   be less than a tick. */
+static void
+hr_sleep(uint64_t cycles) {
+    struct thread *t = thread_current();
+    uint64_t now;
+
+    ASSERT(intr_get_level() == INTR_ON);
+
+    intr_disable();
+    now = rdtsc();
+    t->wakeup_tsc = now + cycles;
+    list_insert_ordered(&hr_list, &t->timer_elem, hr_less, NULL);
+    hr_sleeps++;
+
+    /* Switch to one-shot mode, or move the one-shot earlier. */
+    if (list_front(&hr_list) == &t->timer_elem)
+        timer_reprogram(now);
+    intr_enable();
+
+    sema_down(&t->timer_sema);
+}
+
+/* Wakes the sub-tick sleepers whose deadlines are at or before
+   NOW.  Interrupts must be off. */
+static void
+hr_expire(uint64_t now) {
+    while (!list_empty(&hr_list)) {
+        struct thread *t = list_entry(list_front(&hr_list),
+                                      struct thread, timer_elem);
+        if (t->wakeup_tsc > now)
+            break;
+        list_pop_front(&hr_list);
+        if (now - t->wakeup_tsc > hr_late_max)
+            hr_late_max = now - t->wakeup_tsc;
+        sema_up(&t->timer_sema);
+    }
+}
+
+/* Orders threads by sub-tick wake-up time. */
+static bool
+hr_less(const struct list_elem *a_, const struct list_elem *b_,
+        void *aux UNUSED) {
+    const struct thread *a = list_entry(a_, struct thread, timer_elem);
+    const struct thread *b = list_entry(b_, struct thread, timer_elem);
+
+    return a->wakeup_tsc < b->wakeup_tsc;
+}
+
+/* Programs a one-shot PIT interrupt at TSC time DEADLINE, or as
+   close to it as the PIT reaches, given that it is now NOW.
+   Interrupts must be off. */
+static void
+timer_program(uint64_t deadline, uint64_t now) {
+    uint64_t count = 1;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    /* Round up, so that the interrupt is never early. */
+    if (deadline > now)
+        count = DIV_ROUND_UP((deadline - now) * TICK_CYCLES, tsc_per_tick);
+    if (count > 65536)
+        count = 65536;
+    pit_one_shot(0, count);
+    one_shot = true;
+}
+
+/* Programs the PIT for the next sub-tick deadline or whole tick,
+   whichever comes first, or returns it to periodic mode if no
+   sleeper is waiting and we are at a tick boundary.  Interrupts
+   must be off. */
+static void
+timer_reprogram(uint64_t now) {
+    uint64_t deadline = last_tick_tsc + tsc_per_tick;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!list_empty(&hr_list)) {
+        struct thread *t = list_entry(list_front(&hr_list),
+                                      struct thread, timer_elem);
+        if (t->wakeup_tsc < deadline)
+            deadline = t->wakeup_tsc;
+    } else if (one_shot && now - last_tick_tsc < tsc_per_tick / 16) {
+        pit_configure_channel(0, 2, TIMER_FREQ);
+        last_tick_tsc = now;
+        one_shot = false;
+        return;
+    }
+    timer_program(deadline, now);
+}
+
+/* Advances the tick count by one and leaves the sleepers due on
+   that tick to the timer softirq. */
+static void
+timer_tick(void) {
     ticks++;
     thread_tick();
-    while (!list_empty(&wait_list)) {
-        struct thread *t = list_entry(list_front(&wait_list),
-        struct thread, timer_elem);
-        if (ticks < t->wakeup_time)
-            break;
+    intr_raise_softirq(SOFTIRQ_TIMER);
+}
+
+/* Timer softirq.  Wakes every sleeper due by now, with interrupts
+   on except while taking each one off the wheel. */
+static void
+timer_softirq(void) {
+    uint64_t start, cycles;
+    struct thread *t;
+
+    start = rdtsc();
+    while ((t = wheel_next()) != NULL)
         sema_up(&t->timer_sema);
-        list_pop_front(&wait_list);
+
+    cycles = rdtsc() - start;
+    if (cycles > expire_max_cycles)
+        expire_max_cycles = cycles;
+}
+
+/* Removes and returns a sleeper due by `ticks', advancing the
+   wheel as far as needed to find one, or returns a null pointer
+   once the wheel has caught up with `ticks' and has nobody left
+   to wake. */
+static struct thread *
+wheel_next(void) {
+    enum intr_level old_level = intr_disable();
+    struct thread *t = NULL;
+
+    for (;;) {
+        struct list *slot = &wheel[0][wheel_time & (WHEEL_SLOTS - 1)];
+        int level;
+
+        if (!list_empty(slot)) {
+            t = list_entry(list_pop_front(slot), struct thread, timer_elem);
+            ASSERT(t->wakeup_time <= wheel_time);
+            sleeper_cnt--;
+            break;
+        }
+        if (wheel_time == ticks)
+            break;
+
+        /* Cascade each level whose finer neighbor just wrapped. */
+        wheel_time++;
+        for (level = 1; level < WHEEL_LEVELS; level++) {
+            if ((wheel_time & ((1 << (WHEEL_BITS * level)) - 1)) != 0)
+                break;
+            wheel_cascade(level);
+        }
     }
+    intr_set_level(old_level);
+    return t;
+}
+
+/* Adds sleeping thread T to the timing wheel slot for its
+   wake-up time.  Interrupts must be off. */
+static void
+wheel_insert(struct thread *t) {
+    int64_t delta = t->wakeup_time - wheel_time;
+    int64_t when = t->wakeup_time;
+    int level;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    /* A thread cascaded on its wake-up tick lands in the current
+       level-0 slot, which wheel_next() empties next. */
+    ASSERT(delta >= 0);
+
+    for (level = 0; level < WHEEL_LEVELS - 1; level++)
+        if (delta < (int64_t) 1 << (WHEEL_BITS * (level + 1)))
+            break;
+
+    /* Too far out for the top level: park in its farthest slot. */
+    if (delta >= (int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+        when = wheel_time + ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+    list_push_back(&wheel[level][(when >> (WHEEL_BITS * level))
+                                 & (WHEEL_SLOTS - 1)],
+                   &t->timer_elem);
+}
+
+/* Moves the threads in the current slot of LEVEL down to finer
+   slots.  Interrupts must be off. */
+static void
+wheel_cascade(int level) {
+    struct list *slot = &wheel[level][(wheel_time >> (WHEEL_BITS * level))
+                                      & (WHEEL_SLOTS - 1)];
+    struct list threads;
+
+    list_init(&threads);
+    while (!list_empty(slot))
+        list_push_back(&threads, list_pop_front(slot));
+    while (!list_empty(&threads))
+        wheel_insert(list_entry(list_pop_front(&threads),
+                                struct thread, timer_elem));
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -253,6 +637,11 @@ real_time_sleep(int64_t num, int32_t denom) {
            timer_sleep() because it will yield the CPU to other
            processes. */
         timer_sleep(ticks);
+    } else if (tsc_per_tick != 0
+               && num * (1000 * 1000 * 1000 / HR_SLEEP_MIN_NS) >= denom) {
+        /* Block until a one-shot timer interrupt at the exact
+           time. */
+        hr_sleep(num * tsc_per_tick * TIMER_FREQ / denom);
     } else {
         /* Otherwise, use a busy-wait loop for more accurate
            sub-tick timing. */
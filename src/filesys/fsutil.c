@@ -11,6 +11,10 @@
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 
+/* Position of fsutil_append() on the scratch device: the sector
+   where its end-of-archive marker begins. */
+static block_sector_t append_sector;
+
 /* List files in the root directory. */
 void
 fsutil_ls (char **argv UNUSED) 
@@ -166,8 +170,7 @@ fsutil_extract (char **argv UNUSED)
 void
 fsutil_append (char **argv)
 {
-  static block_sector_t sector = 0;
-
+  block_sector_t sector = append_sector;
   const char *file_name = argv[1];
   void *buffer;
   struct file *src;
@@ -216,8 +219,18 @@ fsutil_append (char **argv)
   memset (buffer, 0, BLOCK_SECTOR_SIZE);
   block_write (dst, sector, buffer);
   block_write (dst, sector, buffer + 1);
+  append_sector = sector;
 
   /* Finish up. */
   file_close (src);
   free (buffer);
 }
+
+/* Returns the sector of the scratch device at which the next
+   fsutil_append() would write, so that other code can add files
+   to the same archive instead of overwriting it. */
+block_sector_t
+fsutil_append_sector (void)
+{
+  return append_sector;
+}
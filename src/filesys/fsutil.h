@@ -1,10 +1,13 @@
 #ifndef FILESYS_FSUTIL_H
 #define FILESYS_FSUTIL_H
 
+#include "devices/block.h"
+
 void fsutil_ls (char **argv);
 void fsutil_cat (char **argv);
 void fsutil_rm (char **argv);
 void fsutil_extract (char **argv);
 void fsutil_append (char **argv);
+block_sector_t fsutil_append_sector (void);
 
 #endif /* filesys/fsutil.h */
@@ -0,0 +1,36 @@
+#ifndef __LIB_SCHEDSTAT_H
+#define __LIB_SCHEDSTAT_H
+
+#include <stdint.h>
+
+/* Scheduler latency histograms, kept system-wide by the kernel
+   when booted with "-schedstat".  Bucket B of a histogram counts
+   intervals of 2**B to 2**(B + 1) - 1 TSC cycles; bucket 0 also
+   counts intervals of 0 cycles and the last bucket everything
+   longer. */
+enum schedstat_hist
+  {
+    SCHEDSTAT_WAKEUP,           /* From thread_unblock() to running. */
+    SCHEDSTAT_REQUEUE,          /* From preemption or yield to running. */
+    SCHEDSTAT_RUN,              /* Time on the CPU per switch-in. */
+    SCHEDSTAT_HIST_CNT          /* Number of histograms. */
+  };
+
+#define SCHEDSTAT_BUCKETS 32
+
+/* Statistics reported by the schedstat system call, which fails
+   unless the kernel was booted with "-schedstat". */
+struct schedstat
+  {
+    /* The calling thread. */
+    uint64_t voluntary;         /* Switches away while blocking. */
+    uint64_t involuntary;       /* Switches away while still runnable. */
+    uint64_t cpu_cycles;        /* TSC cycles spent on the CPU. */
+
+    /* The whole system. */
+    uint64_t sys_voluntary;
+    uint64_t sys_involuntary;
+    uint32_t hist[SCHEDSTAT_HIST_CNT][SCHEDSTAT_BUCKETS];
+  };
+
+#endif /* lib/schedstat.h */
@@ -28,7 +28,22 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Statistics and tuning. */
+    SYS_VMSTAT,                 /* Obtain virtual memory statistics. */
+    SYS_SETTICKETS,             /* Set stride-scheduler tickets. */
+    SYS_LOCKSTAT,               /* Print lock contention statistics. */
+    SYS_SCHEDSTAT,              /* Obtain scheduler latency statistics. */
+
+    /* User-space synchronization. */
+    SYS_FUTEX_WAIT,             /* Sleep if a word holds a value. */
+    SYS_FUTEX_WAKE,             /* Wake threads sleeping on a word. */
+
+    /* User threads. */
+    SYS_THREAD_CREATE,          /* Start a thread in this process. */
+    SYS_THREAD_JOIN,            /* Wait for a thread to end. */
+    SYS_THREAD_EXIT             /* End the calling thread. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -182,3 +182,68 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+vmstat (struct vmstat *stats, bool system)
+{
+  return syscall2 (SYS_VMSTAT, stats, (int) system);
+}
+
+bool
+settickets (int tickets)
+{
+  return syscall1 (SYS_SETTICKETS, tickets);
+}
+
+void
+lockstat (void)
+{
+  syscall0 (SYS_LOCKSTAT);
+}
+
+bool
+schedstat (struct schedstat *stats)
+{
+  return syscall1 (SYS_SCHEDSTAT, stats);
+}
+
+int
+futex_wait (int *addr, int expected)
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, expected);
+}
+
+int
+futex_wake (int *addr, int n)
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* Every thread started by thread_create() begins here, as if
+   called with FUNC and AUX as arguments, and ends when FUNC
+   returns. */
+static void
+thread_start (void (*func) (void *), void *aux)
+{
+  func (aux);
+  thread_exit ();
+}
+
+tid_t
+thread_create (void (*func) (void *), void *aux)
+{
+  return syscall3 (SYS_THREAD_CREATE, thread_start, func, aux);
+}
+
+int
+thread_join (tid_t tid)
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+thread_exit (void)
+{
+  syscall0 (SYS_THREAD_EXIT);
+  NOT_REACHED ();
+}
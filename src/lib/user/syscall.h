@@ -3,11 +3,17 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <schedstat.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* User thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +51,19 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Statistics and tuning. */
+bool vmstat (struct vmstat *, bool system);
+bool settickets (int tickets);
+void lockstat (void);
+bool schedstat (struct schedstat *);
+
+/* User-space synchronization. */
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int n);
+
+/* User threads. */
+tid_t thread_create (void (*func) (void *), void *aux);
+int thread_join (tid_t);
+void thread_exit (void) NO_RETURN;
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,30 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Virtual memory statistics counters, kept system-wide and per
+   thread by the kernel and reported by the vmstat system call. */
+enum vmstat_item
+  {
+    VMSTAT_MINOR_FAULTS,        /* Faults served without disk I/O. */
+    VMSTAT_MAJOR_FAULTS,        /* Faults that read from file or swap. */
+    VMSTAT_ZERO_FILLS,          /* Pages brought in as all zeros. */
+    VMSTAT_FILE_READS,          /* Pages read in from a file. */
+    VMSTAT_SWAP_INS,            /* Pages read in from swap. */
+    VMSTAT_SWAP_OUTS,           /* Pages written out to swap. */
+    VMSTAT_FILE_WRITES,         /* Pages written back to a file. */
+    VMSTAT_EVICTIONS,           /* Pages evicted from their frames. */
+    VMSTAT_SCANS,               /* Frames examined by the clock hand. */
+    VMSTAT_LAPS,                /* Full turns of the clock hand. */
+    VMSTAT_PAGE_IN_CYCLES,      /* CPU cycles spent in page_in(). */
+    VMSTAT_CNT                  /* Number of counters. */
+  };
+
+/* A set of virtual memory statistics counters. */
+struct vmstat
+  {
+    uint64_t count[VMSTAT_CNT];
+  };
+
+#endif /* lib/vmstat.h */
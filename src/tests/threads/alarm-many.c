@@ -0,0 +1,63 @@
+/* Puts 10,000 threads to sleep at once, for random intervals of
+   up to 10 seconds, and checks that none of them wakes up early.
+   Each thread needs a page of its own, so run with as much memory
+   as the loader will use and most of it in the kernel pool
+   ("-m 128" and "-ul=1024").  If memory still runs out, the test
+   stops creating threads early, and the count it prints says
+   so.
+
+   This is mostly a benchmark of the timer's sleep queue: the
+   longest interrupts-off windows spent inserting into it and
+   updating it in the timer interrupt are printed with the timer
+   statistics at shutdown. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 10000
+#define MAX_SLEEP (10 * TIMER_FREQ)
+
+static thread_func sleeper;
+static struct semaphore done_sema;
+static int early_cnt;
+
+void
+test_alarm_many (void) 
+{
+  int thread_cnt;
+  int i;
+
+  sema_init (&done_sema, 0);
+  random_init (0);
+
+  msg ("Starting sleepers...");
+  for (thread_cnt = 0; thread_cnt < THREAD_CNT; thread_cnt++)
+    {
+      int64_t duration = random_ulong () % MAX_SLEEP + 1;
+      if (thread_create ("sleeper", PRI_DEFAULT, sleeper,
+                         (void *) (intptr_t) duration) == TID_ERROR)
+        break;
+    }
+  msg ("Started %d sleepers.", thread_cnt);
+
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done_sema);
+  msg ("All sleepers woke up, %d of them early.", early_cnt);
+}
+
+static void
+sleeper (void *duration_) 
+{
+  int64_t duration = (intptr_t) duration_;
+  int64_t start = timer_ticks ();
+
+  timer_sleep (duration);
+  if (timer_elapsed (start) < duration)
+    early_cnt++;
+  sema_up (&done_sema);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-many) begin
+(alarm-many) Starting sleepers...
+(alarm-many) Started 10000 sleepers.
+(alarm-many) All sleepers woke up, 0 of them early.
+(alarm-many) end
+EOF
+pass;
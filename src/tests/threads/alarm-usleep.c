@@ -0,0 +1,56 @@
+/* Creates several threads that each sleep for a different
+   fraction of a timer tick, the longest sleep first, and checks
+   that they wake up shortest first.  A sub-tick sleep that
+   busy-waited instead of blocking would keep the CPU until it
+   was done, so the threads would finish in creation order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 5
+
+static thread_func sleeper;
+static struct semaphore done_sema;
+static int wake_order[THREAD_CNT];
+static int wake_cnt;
+
+void
+test_alarm_usleep (void) 
+{
+  int i;
+
+  sema_init (&done_sema, 0);
+
+  /* Thread I sleeps (THREAD_CNT - I) / (THREAD_CNT + 1) ticks. */
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      thread_create (name, PRI_DEFAULT, sleeper, (void *) (intptr_t) i);
+    }
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done_sema);
+  for (i = 0; i < THREAD_CNT; i++)
+    msg ("Thread %d woke up.", wake_order[i]);
+}
+
+static void
+sleeper (void *id_) 
+{
+  int id = (intptr_t) id_;
+  enum intr_level old_level;
+
+  timer_usleep ((int64_t) (THREAD_CNT - id) * 1000 * 1000
+                / TIMER_FREQ / (THREAD_CNT + 1));
+
+  old_level = intr_disable ();
+  wake_order[wake_cnt++] = id;
+  intr_set_level (old_level);
+  sema_up (&done_sema);
+}
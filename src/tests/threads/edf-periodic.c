@@ -0,0 +1,112 @@
+/* Runs three periodic real-time threads, reserving 70% of the
+   CPU between them, against two CPU-bound threads in the normal
+   class, and logs the deadlines each periodic thread missed.
+   Under earliest-deadline-first scheduling none should be
+   missed.  Also checks that admission control refuses
+   reservations that would exceed RT_UTIL_MAX. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define JOB_CNT 20
+#define PERIODIC_CNT 3
+#define LOAD_CNT 2
+
+struct periodic_info 
+  {
+    int64_t period;             /* Period, in ticks. */
+    int64_t budget;             /* Reserved ticks per period. */
+    int64_t work;               /* Ticks of work per job. */
+    bool admitted;              /* Reservation accepted? */
+    unsigned misses;            /* Deadlines missed. */
+  };
+
+static thread_func periodic_thread;
+static thread_func load_thread;
+static struct semaphore done_sema;
+static volatile bool stop;
+
+void
+test_edf_periodic (void) 
+{
+  struct periodic_info info[PERIODIC_CNT] = 
+    {
+      {10, 3, 1, false, 0},
+      {20, 4, 2, false, 0},
+      {40, 8, 6, false, 0},
+    };
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Reserving the whole CPU: %s.",
+       thread_set_periodic (10, 10) ? "admitted" : "rejected");
+
+  sema_init (&done_sema, 0);
+  for (i = 0; i < LOAD_CNT; i++)
+    thread_create ("load", PRI_DEFAULT, load_thread, NULL);
+
+  /* Periodic threads preempt us and make their reservations
+     right away. */
+  for (i = 0; i < PERIODIC_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "periodic %d", i);
+      thread_create (name, PRI_DEFAULT + 1, periodic_thread, &info[i]);
+    }
+  for (i = 0; i < PERIODIC_CNT; i++)
+    msg ("Periodic thread %d: period %lld, budget %lld, %s.", i,
+         info[i].period, info[i].budget,
+         info[i].admitted ? "admitted" : "rejected");
+  msg ("Reserving another 30%%: %s.",
+       thread_set_periodic (10, 3) ? "admitted" : "rejected");
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    sema_down (&done_sema);
+  stop = true;
+  for (i = 0; i < LOAD_CNT; i++)
+    sema_down (&done_sema);
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    msg ("Periodic thread %d: %d jobs, %u deadline misses.",
+         i, JOB_CNT, info[i].misses);
+}
+
+static void
+periodic_thread (void *info_) 
+{
+  struct periodic_info *info = info_;
+  int job;
+
+  info->admitted = thread_set_periodic (info->period, info->budget);
+  for (job = 0; job < JOB_CNT; job++) 
+    {
+      /* Spin until we have been running for WORK ticks. */
+      int64_t last_time = timer_ticks ();
+      int64_t ticks = 0;
+      while (ticks < info->work) 
+        {
+          int64_t cur_time = timer_ticks ();
+          if (cur_time != last_time)
+            ticks++;
+          last_time = cur_time;
+        }
+      thread_wait_period ();
+    }
+  info->misses = thread_get_deadline_misses ();
+  thread_set_periodic (0, 0);
+  sema_up (&done_sema);
+}
+
+static void
+load_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    continue;
+  sema_up (&done_sema);
+}
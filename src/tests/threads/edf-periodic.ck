@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-periodic) begin
+(edf-periodic) Reserving the whole CPU: rejected.
+(edf-periodic) Periodic thread 0: period 10, budget 3, admitted.
+(edf-periodic) Periodic thread 1: period 20, budget 4, admitted.
+(edf-periodic) Periodic thread 2: period 40, budget 8, admitted.
+(edf-periodic) Reserving another 30%: rejected.
+(edf-periodic) Periodic thread 0: 20 jobs, 0 deadline misses.
+(edf-periodic) Periodic thread 1: 20 jobs, 0 deadline misses.
+(edf-periodic) Periodic thread 2: 20 jobs, 0 deadline misses.
+(edf-periodic) end
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Keeps interrupts off for a known number of TSC cycles, then
+   prints the interrupts-off report, in which that window should
+   be the worst, opened and closed in this function rather than,
+   say, in the idle thread.  Run with "-irqoff". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/tsc.h"
+
+/* Length of the window, in TSC cycles. */
+#define WINDOW_CYCLES 10000000
+
+void
+test_irqoff_trace (void) 
+{
+  enum intr_level old_level;
+  uint64_t start;
+
+  ASSERT (intr_trace);
+
+  old_level = intr_disable ();
+  start = rdtsc ();
+  while (rdtsc () - start < WINDOW_CYCLES)
+    continue;
+  intr_set_level (old_level);
+
+  msg ("window of %d cycles done", WINDOW_CYCLES);
+  msg ("window opened and closed in code at %p",
+       (void *) test_irqoff_trace);
+  intr_print_stats ();
+}
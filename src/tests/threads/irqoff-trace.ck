@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "Missing window message.\n"
+  if !grep (/^\(irqoff-trace\) window of 10000000 cycles done$/, @output);
+my ($worst) = grep (/^Interrupts off: #1 /, @output);
+fail "No worst window in the report.\n" if !defined $worst;
+my ($cycles, $off, $on)
+  = $worst =~ /^Interrupts off: #1 (\d+) cycles, off at (0x[0-9a-f]+), on at (0x[0-9a-f]+)$/
+  or fail "Malformed window line: $worst\n";
+fail "Worst window is $cycles cycles, expected at least 10000000.\n"
+  if $cycles < 10000000;
+my ($code) = map (/^\(irqoff-trace\) window opened and closed in code at (0x[0-9a-f]+)$/, @output);
+fail "Missing test code address.\n" if !defined $code;
+foreach my $site ($off, $on) {
+    # The test function is well under 0x200 bytes long.
+    fail "Worst window ($off to $on) is not the test's own, at $code.\n"
+      if hex ($site) < hex ($code) || hex ($site) >= hex ($code) + 0x200;
+}
+my ($stack) = grep (/^Call stack:/, @output);
+fail "No call stack line for utils/backtrace.\n" if !defined $stack;
+fail "Call stack does not begin with the worst window's sites.\n"
+  if $stack !~ /^Call stack: $off $on[ .]/;
+pass;
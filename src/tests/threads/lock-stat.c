@@ -0,0 +1,55 @@
+/* Has several threads take turns holding a named lock for a
+   tick at a time, then prints the lock contention report, which
+   should show every acquisition after the first few as
+   contended.  Run with "-lockstat". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4
+#define ITER_CNT 5
+
+static thread_func locker;
+static struct lock lock;
+static struct semaphore done_sema;
+
+void
+test_lock_stat (void) 
+{
+  int i;
+
+  ASSERT (lock_stat);
+
+  lock_init (&lock);
+  lock_set_name (&lock, "lock-stat");
+  sema_init (&done_sema, 0);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    thread_create ("locker", PRI_DEFAULT, locker, NULL);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done_sema);
+
+  lock_print_stats ();
+}
+
+static void
+locker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      lock_acquire (&lock);
+      timer_sleep (1);
+      lock_release (&lock);
+
+      /* Let the waiter we woke take the lock before we try
+         again. */
+      thread_yield ();
+    }
+  sema_up (&done_sema);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my ($line) = grep (/^Lock: lock-stat\s/, @output);
+fail "No statistics for the test lock in the report.\n" if !defined $line;
+my ($acquired, $contended, $wait, $max_wait, $max_hold)
+  = $line =~ /^Lock: lock-stat\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)$/
+  or fail "Malformed statistics line: $line\n";
+fail "Lock acquired $acquired times, expected 20.\n" if $acquired != 20;
+fail "Only $contended of 20 acquisitions were contended.\n"
+  if $contended < 10;
+fail "Waits add up to less than the longest wait.\n" if $wait < $max_wait;
+fail "No hold time recorded.\n" if $max_hold == 0;
+pass;
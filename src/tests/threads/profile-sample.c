@@ -0,0 +1,33 @@
+/* Spins in a kernel function for a number of timer ticks, then
+   prints the profile, in which most kernel samples should have
+   caught the spinning function and at least one of its callers.
+   Run with "-profile". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/profile.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+
+/* Number of ticks to spin for. */
+#define SPIN_TICKS 50
+
+static void spin (int64_t start) NO_INLINE;
+
+void
+test_profile_sample (void) 
+{
+  ASSERT (profile_enabled);
+
+  spin (timer_ticks ());
+  msg ("spun for %d ticks", SPIN_TICKS);
+  profile_dump ();
+}
+
+static void
+spin (int64_t start) 
+{
+  while (timer_elapsed (start) < SPIN_TICKS)
+    barrier ();
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "Missing spin message.\n"
+  if !grep (/^\(profile-sample\) spun for 50 ticks$/, @output);
+my ($summary) = grep (/^Profile: \d+ kernel samples/, @output);
+fail "No kernel sample summary.\n" if !defined $summary;
+my ($cnt) = $summary =~ /^Profile: (\d+) kernel samples, (\d+) kept$/
+  or fail "Malformed summary line: $summary\n";
+fail "Only $cnt kernel samples in 50 ticks.\n" if $cnt < 40;
+my (@samples) = grep (/^Profile: K /, @output);
+fail "Summary reports samples but none were printed.\n" if !@samples;
+foreach (@samples) {
+    fail "Malformed sample line: $_\n"
+      if !/^Profile: K(?: 0x[0-9a-f]{8})+$/;
+}
+fail "No kernel sample has a caller; are frame pointers kept?\n"
+  if !grep (/^Profile: K 0x[0-9a-f]{8} 0x/, @samples);
+pass;
@@ -0,0 +1,116 @@
+/* Benchmarks a reader-writer lock against a plain lock.
+
+   READER_CNT threads repeatedly hold the lock for reading for a
+   tick each, sleeping inside the critical section the way a
+   reader blocked on disk I/O would, while one writer now and
+   then holds it for writing.  With a plain lock every critical
+   section runs alone; with a reader-writer lock the readers
+   overlap, so the run should take far fewer ticks.  Because the
+   reader-writer lock prefers writers, the writer should never
+   wait for more than the readers already inside, even though
+   readers keep coming back. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 8
+#define READER_ITERS 20
+#define WRITER_ITERS 10
+
+static thread_func reader, writer;
+static bool use_rwlock;
+static struct lock lock;
+static struct rwlock rwlock;
+static struct semaphore done_sema;
+static int64_t writer_max_wait;
+
+static int64_t run (bool);
+
+void
+test_rwlock_bench (void) 
+{
+  int64_t lock_ticks, rwlock_ticks;
+
+  lock_init (&lock);
+  rwlock_init (&rwlock);
+  sema_init (&done_sema, 0);
+
+  lock_ticks = run (false);
+  msg ("Plain lock: %"PRId64" ticks.", lock_ticks);
+  rwlock_ticks = run (true);
+  msg ("Reader-writer lock: %"PRId64" ticks.", rwlock_ticks);
+  msg ("Writer waited at most %"PRId64" ticks.", writer_max_wait);
+}
+
+/* Runs the readers and the writer to completion using a
+   reader-writer lock if RW, otherwise a plain lock, and returns
+   the number of ticks taken. */
+static int64_t
+run (bool rw) 
+{
+  int64_t start;
+  int i;
+
+  use_rwlock = rw;
+  writer_max_wait = 0;
+
+  start = timer_ticks ();
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader, NULL);
+  thread_create ("writer", PRI_DEFAULT, writer, NULL);
+  for (i = 0; i < READER_CNT + 1; i++)
+    sema_down (&done_sema);
+  return timer_elapsed (start);
+}
+
+static void
+reader (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < READER_ITERS; i++)
+    if (use_rwlock)
+      {
+        rwlock_acquire_read (&rwlock);
+        timer_sleep (1);
+        rwlock_release_read (&rwlock);
+      }
+    else
+      {
+        lock_acquire (&lock);
+        timer_sleep (1);
+        lock_release (&lock);
+      }
+  sema_up (&done_sema);
+}
+
+static void
+writer (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < WRITER_ITERS; i++)
+    {
+      int64_t start = timer_ticks ();
+
+      if (use_rwlock)
+        rwlock_acquire_write (&rwlock);
+      else
+        lock_acquire (&lock);
+      if (timer_elapsed (start) > writer_max_wait)
+        writer_max_wait = timer_elapsed (start);
+      timer_sleep (1);
+      if (use_rwlock)
+        rwlock_release_write (&rwlock);
+      else
+        lock_release (&lock);
+
+      timer_sleep (2);
+    }
+  sema_up (&done_sema);
+}
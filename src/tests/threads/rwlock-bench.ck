@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my ($lock_ticks, $rwlock_ticks, $max_wait);
+foreach (@output) {
+    $lock_ticks = $1 if /Plain lock: (\d+) ticks\./;
+    $rwlock_ticks = $1 if /Reader-writer lock: (\d+) ticks\./;
+    $max_wait = $1 if /Writer waited at most (\d+) ticks\./;
+}
+fail "Benchmark results missing from output.\n"
+  if !defined ($lock_ticks) || !defined ($rwlock_ticks) || !defined ($max_wait);
+fail "Readers did not overlap: reader-writer lock took $rwlock_ticks "
+  . "ticks, plain lock $lock_ticks.\n"
+  if $rwlock_ticks * 2 > $lock_ticks;
+fail "Writer waited $max_wait ticks behind readers.\n"
+  if $max_wait > 3;
+pass;
@@ -0,0 +1,71 @@
+/* Ping-pongs between two threads with semaphores, so that each
+   round trip blocks and wakes each thread once, and checks that
+   the scheduler latency tracing saw every switch.  Run with
+   "-schedstat". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUND_CNT 100
+
+static thread_func pong;
+static struct semaphore ping_sema, pong_sema;
+
+static uint64_t hist_total (const struct schedstat *, enum schedstat_hist);
+
+void
+test_sched_latency (void) 
+{
+  struct schedstat before, after;
+  int i;
+
+  ASSERT (thread_schedstat);
+
+  sema_init (&ping_sema, 0);
+  sema_init (&pong_sema, 0);
+  thread_create ("pong", PRI_DEFAULT, pong, NULL);
+
+  thread_get_schedstat (&before);
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_up (&ping_sema);
+      sema_down (&pong_sema);
+    }
+  thread_get_schedstat (&after);
+
+  msg ("Blocked at least %d times: %s.", ROUND_CNT,
+       after.voluntary - before.voluntary >= ROUND_CNT ? "yes" : "no");
+  msg ("Wakeups traced at least %d times: %s.", 2 * ROUND_CNT,
+       hist_total (&after, SCHEDSTAT_WAKEUP)
+       - hist_total (&before, SCHEDSTAT_WAKEUP) >= 2 * ROUND_CNT
+       ? "yes" : "no");
+  msg ("Time on CPU recorded: %s.",
+       after.cpu_cycles > before.cpu_cycles ? "yes" : "no");
+}
+
+static void
+pong (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_down (&ping_sema);
+      sema_up (&pong_sema);
+    }
+}
+
+/* Returns the number of intervals in histogram H of STATS. */
+static uint64_t
+hist_total (const struct schedstat *stats, enum schedstat_hist h) 
+{
+  uint64_t total = 0;
+  int b;
+
+  for (b = 0; b < SCHEDSTAT_BUCKETS; b++)
+    total += stats->hist[h][b];
+  return total;
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-latency) begin
+(sched-latency) Blocked at least 100 times: yes.
+(sched-latency) Wakeups traced at least 200 times: yes.
+(sched-latency) Time on CPU recorded: yes.
+(sched-latency) end
+EOF
+pass;
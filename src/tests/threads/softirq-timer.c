@@ -0,0 +1,32 @@
+/* Sleeps for 1 through 10 ticks in turn and checks that each
+   sleep lasts the right number of ticks now that sleepers are
+   woken by the timer softirq rather than by the timer interrupt
+   itself.  Then prints the interrupt statistics, which should
+   show that the timer softirq ran. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "devices/timer.h"
+
+void
+test_softirq_timer (void) 
+{
+  int i;
+
+  for (i = 1; i <= 10; i++)
+    {
+      int64_t start = timer_ticks ();
+      int64_t elapsed;
+
+      timer_sleep (i);
+      elapsed = timer_elapsed (start);
+      if (elapsed < i)
+        fail ("woke after %lld ticks of a %d-tick sleep", elapsed, i);
+      if (elapsed > i + 1)
+        fail ("woke %lld ticks late from a %d-tick sleep", elapsed - i, i);
+    }
+  msg ("10 sleeps done");
+  intr_print_stats ();
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "Missing completion message.\n"
+  if !grep (/^\(softirq-timer\) 10 sleeps done$/, @output);
+my ($line) = grep (/^Softirq timer:/, @output);
+fail "No timer softirq statistics.\n" if !defined $line;
+my ($raised, $runs)
+  = $line =~ /^Softirq timer: (\d+) raised, (\d+) runs, \d+ cycles avg, \d+ cycles max$/
+  or fail "Malformed softirq line: $line\n";
+fail "Timer softirq ran only $runs times in 55 ticks of sleep.\n"
+  if $runs < 55;
+fail "Timer softirq ran $runs times but was raised only $raised.\n"
+  if $runs > $raised;
+pass;
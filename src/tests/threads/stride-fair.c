@@ -0,0 +1,101 @@
+/* Measures the fairness of the stride scheduler.
+
+   Each test starts a few threads with the given ticket counts,
+   lets them all spin for 30 seconds, and reports how many timer
+   ticks each one saw.  The ticks should be divided among the
+   threads in proportion to their tickets, and should sum to
+   approximately 30 * 100 == 3000 ticks.
+
+   The stride-fair-2 test runs 2 threads with 100 tickets each,
+   which should receive about 1,500 ticks apiece.
+
+   The stride-ratio test runs 3 threads with 100, 200, and 300
+   tickets, which should receive about 500, 1,000, and 1,500
+   ticks, respectively. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static void test_stride_fair (int thread_cnt, const int tickets[]);
+
+void
+test_stride_fair_2 (void) 
+{
+  static const int tickets[] = {100, 100};
+  test_stride_fair (2, tickets);
+}
+
+void
+test_stride_ratio (void) 
+{
+  static const int tickets[] = {100, 200, 300};
+  test_stride_fair (3, tickets);
+}
+
+#define MAX_THREAD_CNT 20
+
+struct thread_info 
+  {
+    int64_t start_time;
+    int tick_count;
+    int tickets;
+  };
+
+static void load_thread (void *aux);
+
+static void
+test_stride_fair (int thread_cnt, const int tickets[])
+{
+  struct thread_info info[MAX_THREAD_CNT];
+  int64_t start_time;
+  int i;
+
+  ASSERT (thread_stride);
+  ASSERT (thread_cnt <= MAX_THREAD_CNT);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", thread_cnt);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->tickets = tickets[i];
+
+      snprintf(name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+  msg ("Starting threads took %"PRId64" ticks.", timer_elapsed (start_time));
+
+  msg ("Sleeping 40 seconds to let threads run, please wait...");
+  timer_sleep (40 * TIMER_FREQ);
+  
+  for (i = 0; i < thread_cnt; i++)
+    msg ("Thread %d received %d ticks.", i, info[i].tick_count);
+}
+
+static void
+load_thread (void *ti_) 
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 5 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 30 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  if (!thread_set_tickets (ti->tickets))
+    fail ("thread_set_tickets (%d) failed", ti->tickets);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -17,6 +17,8 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-many", test_alarm_many},
+    {"alarm-usleep", test_alarm_usleep},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -38,6 +40,18 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"stride-fair-2", test_stride_fair_2},
+    {"stride-ratio", test_stride_ratio},
+    {"edf-periodic", test_edf_periodic},
+    {"rwlock-bench", test_rwlock_bench},
+    {"lock-stat", test_lock_stat},
+    {"sched-latency", test_sched_latency},
+    {"thread-churn", test_thread_churn},
+    {"workqueue", test_workqueue},
+    {"irqoff-trace", test_irqoff_trace},
+    {"profile-sample", test_profile_sample},
+    {"trace-basic", test_trace_basic},
+    {"softirq-timer", test_softirq_timer},
   };
 
 static const char *test_name;
@@ -11,6 +11,8 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_many;
+extern test_func test_alarm_usleep;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -32,6 +34,18 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_stride_fair_2;
+extern test_func test_stride_ratio;
+extern test_func test_edf_periodic;
+extern test_func test_rwlock_bench;
+extern test_func test_lock_stat;
+extern test_func test_sched_latency;
+extern test_func test_thread_churn;
+extern test_func test_workqueue;
+extern test_func test_irqoff_trace;
+extern test_func test_profile_sample;
+extern test_func test_trace_basic;
+extern test_func test_softirq_timer;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,38 @@
+/* Creates many short-lived threads one after another, each of
+   which exits right away, and checks that they all ran.  This
+   exercises the recycling of thread pages: the thread statistics
+   printed at shutdown should show nearly every page reused. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 2000
+
+static thread_func worker;
+static struct semaphore done_sema;
+static int run_cnt;
+
+void
+test_thread_churn (void) 
+{
+  int i;
+
+  sema_init (&done_sema, 0);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      if (thread_create ("worker", PRI_DEFAULT, worker, NULL) == TID_ERROR)
+        fail ("thread_create failed after %d threads", i);
+      sema_down (&done_sema);
+    }
+  msg ("%d of %d threads ran.", run_cnt, THREAD_CNT);
+}
+
+static void
+worker (void *aux UNUSED) 
+{
+  run_cnt++;
+  sema_up (&done_sema);
+}
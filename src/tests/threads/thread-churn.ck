@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-churn) begin
+(thread-churn) 2000 of 2000 threads ran.
+(thread-churn) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Switches between two threads a number of times with "-trace",
+   then dumps the trace, which should hold at least one context
+   switch record for each switch.  The threads tests have no
+   scratch device, so the dump itself is discarded. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/trace.h"
+
+/* Number of times each thread yields. */
+#define YIELD_CNT 20
+
+static thread_func yielder;
+
+void
+test_trace_basic (void) 
+{
+  ASSERT (trace_enabled);
+
+  thread_create ("yielder", PRI_DEFAULT, yielder, NULL);
+  yielder (NULL);
+  msg ("yielded %d times", YIELD_CNT);
+  trace_dump ();
+}
+
+static void
+yielder (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "Missing yield message.\n"
+  if !grep (/^\(trace-basic\) yielded 20 times$/, @output);
+my ($summary) = grep (/^Trace: \d+ records/, @output);
+fail "No trace summary.\n" if !defined $summary;
+my ($cnt, $kept) = $summary =~ /^Trace: (\d+) records, (\d+) kept$/
+  or fail "Malformed summary line: $summary\n";
+fail "Only $cnt records for 40 yields.\n" if $cnt < 40;
+fail "Kept $kept of $cnt records.\n" if $kept == 0 || $kept > $cnt;
+fail "Trace was not discarded for lack of a scratch device.\n"
+  if !grep (/^Trace: no scratch device, trace discarded$/, @output);
+pass;
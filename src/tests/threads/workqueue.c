@@ -0,0 +1,66 @@
+/* Checks work queues: items run in the order queued, an item
+   queued again while still pending runs only once, and a queue
+   whose workers have higher priority than the queuer runs items
+   right away. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+#define WORK_CNT 5
+
+static work_func record;
+static struct workqueue low_wq, high_wq;
+static struct work works[WORK_CNT];
+static struct semaphore done_sema;
+
+void
+test_workqueue (void) 
+{
+  enum intr_level old_level;
+  bool queued[3];
+  int i;
+
+  sema_init (&done_sema, 0);
+  if (!workqueue_init (&low_wq, "wq-low", PRI_DEFAULT - 1, 1)
+      || !workqueue_init (&high_wq, "wq-high", PRI_DEFAULT + 1, 1))
+    fail ("workqueue_init failed");
+  for (i = 0; i < WORK_CNT; i++)
+    work_init (&works[i], record, (void *) (intptr_t) i);
+
+  msg ("Queuing %d items at lower priority.", WORK_CNT);
+  for (i = 0; i < WORK_CNT; i++)
+    work_queue (&low_wq, &works[i]);
+  msg ("Waiting for them.");
+  for (i = 0; i < WORK_CNT; i++)
+    sema_down (&done_sema);
+
+  /* Queue the same item repeatedly, as an interrupt handler
+     might before its worker gets to run. */
+  msg ("Queuing item 0 three times.");
+  old_level = intr_disable ();
+  for (i = 0; i < 3; i++)
+    queued[i] = work_queue (&low_wq, &works[0]);
+  intr_set_level (old_level);
+  for (i = 0; i < 3; i++)
+    msg ("Queued: %s.", queued[i] ? "yes" : "no");
+  sema_down (&done_sema);
+  msg ("Item 0 %s again.",
+       sema_try_down (&done_sema) ? "ran more than once" : "did not run");
+
+  msg ("Queuing item 1 at higher priority.");
+  work_queue (&high_wq, &works[1]);
+  msg ("Back from queuing.");
+  sema_down (&done_sema);
+}
+
+static void
+record (struct work *work) 
+{
+  msg ("Item %d ran.", (int) (intptr_t) work->aux);
+  sema_up (&done_sema);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Queuing 5 items at lower priority.
+(workqueue) Waiting for them.
+(workqueue) Item 0 ran.
+(workqueue) Item 1 ran.
+(workqueue) Item 2 ran.
+(workqueue) Item 3 ran.
+(workqueue) Item 4 ran.
+(workqueue) Queuing item 0 three times.
+(workqueue) Queued: yes.
+(workqueue) Queued: no.
+(workqueue) Queued: no.
+(workqueue) Item 0 ran.
+(workqueue) Item 0 did not run again.
+(workqueue) Queuing item 1 at higher priority.
+(workqueue) Item 1 ran.
+(workqueue) Back from queuing.
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,22 @@
+/* Checks the futex system calls on a word in the data segment
+   and a word on the stack: waiting when the word does not hold
+   the expected value returns at once, and waking a word that
+   nobody waits on wakes nobody. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 42;
+
+void
+test_main (void)
+{
+  int stack_word = 7;
+
+  CHECK (futex_wait (&word, 41) == -1, "wait on data word, wrong value");
+  CHECK (futex_wake (&word, 1) == 0, "wake data word, no waiters");
+  CHECK (futex_wait (&stack_word, 8) == -1,
+         "wait on stack word, wrong value");
+  CHECK (futex_wake (&stack_word, 10) == 0, "wake stack word, no waiters");
+}
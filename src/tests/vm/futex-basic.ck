@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-basic) begin
+(futex-basic) wait on data word, wrong value
+(futex-basic) wake data word, no waiters
+(futex-basic) wait on stack word, wrong value
+(futex-basic) wake stack word, no waiters
+(futex-basic) end
+EOF
+pass;
@@ -0,0 +1,70 @@
+/* Starts several threads that all wait on one futex word and
+   checks the counts that futex_wake returns under contention:
+   waking them one at a time never wakes more than one, together
+   the wakes account for every waiter exactly once, and a wake
+   after that finds nobody.  Then does the same with wakes of
+   every waiter at once.  A waiter may not be asleep yet when a
+   wake is issued, so the test keeps waking until all of them
+   have been counted. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 8
+
+/* The futex word.  It stays 0, so every wait blocks. */
+static int word;
+
+static volatile int arrived;
+static volatile int woken;
+
+static void
+waiter (void *aux UNUSED)
+{
+  __sync_fetch_and_add (&arrived, 1);
+  if (futex_wait (&word, 0) != 0)
+    fail ("futex_wait did not block");
+  __sync_fetch_and_add (&woken, 1);
+}
+
+/* Starts THREAD_CNT waiters, wakes them with futex_wake (&word,
+   N) until all have been woken, checking each count, and joins
+   them. */
+static void
+wake_waiters (int n)
+{
+  tid_t tids[THREAD_CNT];
+  int left;
+  int i;
+
+  arrived = woken = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    if ((tids[i] = thread_create (waiter, NULL)) == TID_ERROR)
+      fail ("create thread %d", i);
+  while (arrived < THREAD_CNT)
+    continue;
+
+  for (left = THREAD_CNT; left > 0; )
+    {
+      int cnt = futex_wake (&word, n);
+      if (cnt < 0 || cnt > n || cnt > left)
+        fail ("futex_wake (%d) woke %d with %d waiters left", n, cnt, left);
+      left -= cnt;
+    }
+  msg ("woke %d waiters, at most %d at a time", THREAD_CNT, n);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (thread_join (tids[i]) != 0)
+      fail ("join thread %d", i);
+  if (woken != THREAD_CNT)
+    fail ("%d waiters returned, expected %d", woken, THREAD_CNT);
+  CHECK (futex_wake (&word, THREAD_CNT) == 0, "wake with no waiters left");
+}
+
+void
+test_main (void)
+{
+  wake_waiters (1);
+  wake_waiters (THREAD_CNT);
+}
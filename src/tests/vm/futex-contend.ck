@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-contend) begin
+(futex-contend) woke 8 waiters, at most 1 at a time
+(futex-contend) wake with no waiters left
+(futex-contend) woke 8 waiters, at most 8 at a time
+(futex-contend) wake with no waiters left
+(futex-contend) end
+EOF
+pass;
@@ -0,0 +1,67 @@
+/* Starts several threads in one process that share a counter,
+   protected by a futex-based lock, and a result array, joins
+   them, and checks that the main thread sees all of their
+   writes.  Each thread also checks that its stack is its own. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITERATIONS 1000
+
+/* A lock word: 0 if free, 1 if held, 2 if held with waiters. */
+static int lock;
+static int counter;
+static int results[THREAD_CNT];
+
+static void
+acquire (void)
+{
+  while (__sync_lock_test_and_set (&lock, 2) != 0)
+    futex_wait (&lock, 2);
+}
+
+static void
+release (void)
+{
+  __sync_lock_release (&lock);
+  futex_wake (&lock, 1);
+}
+
+static void
+worker (void *aux)
+{
+  int id = (int) aux;
+  volatile int local = id;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      acquire ();
+      counter++;
+      release ();
+    }
+  results[id] = local == id ? id + 1 : -1;
+}
+
+void
+test_main (void)
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_create (worker, (void *) i)) != TID_ERROR,
+           "create thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == 0, "join thread %d", i);
+  CHECK (thread_join (tids[0]) == -1, "join thread 0 again");
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (results[i] != i + 1)
+      fail ("thread %d result %d, expected %d", i, results[i], i + 1);
+  if (counter != THREAD_CNT * ITERATIONS)
+    fail ("counter is %d, expected %d", counter, THREAD_CNT * ITERATIONS);
+  msg ("counter is %d", counter);
+}
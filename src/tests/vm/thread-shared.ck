@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(thread-shared) begin
+(thread-shared) create thread 0
+(thread-shared) create thread 1
+(thread-shared) create thread 2
+(thread-shared) create thread 3
+(thread-shared) join thread 0
+(thread-shared) join thread 1
+(thread-shared) join thread 2
+(thread-shared) join thread 3
+(thread-shared) join thread 0 again
+(thread-shared) counter is 4000
+(thread-shared) end
+EOF
+pass;
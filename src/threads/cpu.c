@@ -0,0 +1,188 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/init.h"
+#include "threads/vaddr.h"
+
+/* Per-CPU state and processor discovery.
+
+   Everything the kernel keeps for "the CPU" rather than for a
+   thread or for the system as a whole lives in a struct cpu, so
+   that it can be replicated when more than one processor runs
+   kernel code.  Code reaches its own CPU's copy through
+   cpu_current().
+
+   cpu_init() finds the processors in the machine by reading the
+   Intel MultiProcessor Specification tables that the BIOS leaves
+   in low memory, which QEMU provides for its "-smp" option.  Only
+   the bootstrap processor is brought online: the others stay
+   halted, as the BIOS left them, and are only counted.  Starting
+   them needs a local APIC driver and a real-mode trampoline, and
+   the scheduler and synchronization primitives to stop relying on
+   intr_disable() for mutual exclusion. */
+
+/* Per-CPU state, indexed by struct cpu's `id'. */
+struct cpu cpus[CPU_MAX];
+
+/* Number of processors found, at least 1. */
+unsigned cpu_cnt;
+
+/* MP floating pointer structure.  See [MP] 4.1. */
+struct mp_float
+  {
+    char signature[4];          /* "_MP_". */
+    uint32_t config;            /* Physical address of configuration table. */
+    uint8_t length;             /* Length in 16-byte paragraphs, i.e. 1. */
+    uint8_t spec_rev;           /* Specification revision. */
+    uint8_t checksum;           /* All bytes sum to 0. */
+    uint8_t features[5];        /* Default configuration type, etc. */
+  } __attribute__ ((packed));
+
+/* MP configuration table header.  See [MP] 4.2. */
+struct mp_config
+  {
+    char signature[4];          /* "PCMP". */
+    uint16_t length;            /* Length of base table, with header. */
+    uint8_t spec_rev;           /* Specification revision. */
+    uint8_t checksum;           /* All bytes of base table sum to 0. */
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_cnt;         /* Number of entries following header. */
+    uint32_t lapic;             /* Physical address of local APICs. */
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+  } __attribute__ ((packed));
+
+/* MP configuration table entry types and sizes.  See [MP] 4.3. */
+#define MP_PROCESSOR 0          /* Processor entry, 20 bytes. */
+#define MP_PROCESSOR_SIZE 20
+#define MP_OTHER_SIZE 8         /* Every other entry type. */
+
+/* Processor entry.  See [MP] 4.3.1. */
+struct mp_processor
+  {
+    uint8_t type;               /* MP_PROCESSOR. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    uint8_t apic_version;
+    uint8_t flags;              /* MPP_* flags. */
+    uint32_t signature;         /* CPUID stepping, model, family. */
+    uint32_t features;          /* CPUID feature flags. */
+    uint32_t reserved[2];
+  } __attribute__ ((packed));
+
+#define MPP_ENABLED 0x01        /* Processor usable. */
+#define MPP_BSP 0x02            /* Bootstrap processor. */
+
+static const struct mp_float *mp_search (void);
+static const struct mp_float *mp_search_range (uintptr_t, size_t);
+static bool checksum_ok (const void *, size_t);
+
+/* Sets up the bootstrap processor's struct cpu and counts the
+   other processors in the machine. */
+void
+cpu_init (void)
+{
+  const struct mp_float *mpf;
+  const struct mp_config *conf = NULL;
+
+  cpus[0].id = 0;
+  cpus[0].bsp = true;
+  cpus[0].online = true;
+  cpu_cnt = 1;
+
+  mpf = mp_search ();
+  if (mpf != NULL && mpf->config != 0
+      && mpf->config + sizeof *conf <= init_ram_pages * PGSIZE)
+    {
+      conf = ptov (mpf->config);
+      if (memcmp (conf->signature, "PCMP", 4)
+          || mpf->config + conf->length > init_ram_pages * PGSIZE
+          || !checksum_ok (conf, conf->length))
+        conf = NULL;
+    }
+
+  if (conf != NULL)
+    {
+      const uint8_t *e = (const uint8_t *) (conf + 1);
+      const uint8_t *end = (const uint8_t *) conf + conf->length;
+      size_t i;
+
+      for (i = 0; i < conf->entry_cnt && e < end; i++)
+        {
+          const struct mp_processor *p = (const struct mp_processor *) e;
+
+          if (p->type != MP_PROCESSOR)
+            {
+              e += MP_OTHER_SIZE;
+              continue;
+            }
+          e += MP_PROCESSOR_SIZE;
+          if (!(p->flags & MPP_ENABLED))
+            continue;
+
+          /* The bootstrap processor is always cpus[0]. */
+          if (p->flags & MPP_BSP)
+            cpus[0].apic_id = p->apic_id;
+          else if (cpu_cnt < CPU_MAX)
+            {
+              cpus[cpu_cnt].id = cpu_cnt;
+              cpus[cpu_cnt].apic_id = p->apic_id;
+              cpu_cnt++;
+            }
+        }
+    }
+
+  printf ("CPU: %u processor%s found, 1 online.\n",
+          cpu_cnt, cpu_cnt == 1 ? "" : "s");
+}
+
+/* Looks for the MP floating pointer structure where [MP] 4 says
+   it may be: in the first kB of the extended BIOS data area, in
+   the last kB of base memory, or in the BIOS ROM.  Returns it,
+   or a null pointer if there is none. */
+static const struct mp_float *
+mp_search (void)
+{
+  const uint8_t *bda = ptov (0x400);
+  const struct mp_float *mpf;
+  uintptr_t ebda, base_top;
+
+  ebda = (uintptr_t) *(const uint16_t *) (bda + 0x0e) << 4;
+  if (ebda != 0 && (mpf = mp_search_range (ebda, 1024)) != NULL)
+    return mpf;
+  base_top = (uintptr_t) *(const uint16_t *) (bda + 0x13) * 1024;
+  if (base_top >= 1024 && (mpf = mp_search_range (base_top - 1024, 1024)))
+    return mpf;
+  return mp_search_range (0xf0000, 0x10000);
+}
+
+/* Looks for the MP floating pointer structure in the SIZE bytes
+   of physical memory starting at START. */
+static const struct mp_float *
+mp_search_range (uintptr_t start, size_t size)
+{
+  const uint8_t *p = ptov (start);
+  const uint8_t *end = p + size;
+
+  for (; p + sizeof (struct mp_float) <= end; p += 16)
+    if (!memcmp (p, "_MP_", 4) && checksum_ok (p, sizeof (struct mp_float)))
+      return (const struct mp_float *) p;
+  return NULL;
+}
+
+/* Returns true if the SIZE bytes at P sum to 0 modulo 256. */
+static bool
+checksum_ok (const void *p_, size_t size)
+{
+  const uint8_t *p = p_;
+  uint8_t sum = 0;
+
+  while (size-- > 0)
+    sum += *p++;
+  return sum == 0;
+}
@@ -0,0 +1,42 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Most processors cpu_init() will record. */
+#define CPU_MAX 16
+
+/* Per-CPU state.  See cpu.c for details. */
+struct cpu
+  {
+    unsigned id;                /* Index in cpus[]. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    bool bsp;                   /* Bootstrap processor? */
+    bool online;                /* Running kernel code? */
+
+    /* Scheduler state, owned by thread.c. */
+    struct thread *idle_thread; /* Runs when nothing else is ready. */
+    unsigned thread_ticks;      /* # of timer ticks since last yield. */
+    long long idle_ticks;       /* # of timer ticks spent idle. */
+    long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+    long long user_ticks;       /* # of timer ticks in user programs. */
+  };
+
+extern struct cpu cpus[CPU_MAX];
+extern unsigned cpu_cnt;
+
+void cpu_init (void);
+
+/* Returns the CPU running the caller.  Only the bootstrap
+   processor runs kernel code for now, so that is always cpus[0];
+   once others do, this becomes a lookup by local APIC ID. */
+static inline struct cpu *
+cpu_current (void)
+{
+  return &cpus[0];
+}
+
+#endif /* threads/cpu.h */
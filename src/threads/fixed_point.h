@@ -8,27 +8,27 @@ typedef int fixed_t;
 
 /* Some helpful macros. */
 /* Convert a value to fixed-point value. */
-#define FP_CONST(A) ((fixed_t)(A << FP_SHIFT_AMOUNT))
+#define FP_CONST(A) ((fixed_t)((A) << FP_SHIFT_AMOUNT))
 /* Add two fixed-point value. */
-#define FP_ADD(A,B) (A + B)
+#define FP_ADD(A,B) ((A) + (B))
 /* Add a fixed-point value A and an int value B. */
-#define FP_ADD_MIX(A,B) (A + (B << FP_SHIFT_AMOUNT))
+#define FP_ADD_MIX(A,B) ((A) + ((B) << FP_SHIFT_AMOUNT))
 /* Substract two fixed-point value. */
-#define FP_SUB(A,B) (A - B)
+#define FP_SUB(A,B) ((A) - (B))
 /* Substract an int value B from a fixed-point value A */
-#define FP_SUB_MIX(A,B) (A - (B << FP_SHIFT_AMOUNT))
+#define FP_SUB_MIX(A,B) ((A) - ((B) << FP_SHIFT_AMOUNT))
 /* Multiply a fixed-point value A by an int value B. */
-#define FP_MULT_MIX(A,B) (A * B)
+#define FP_MULT_MIX(A,B) ((A) * (B))
 /* Divide a fixed-point value A by an int value B. */
-#define FP_DIV_MIX(A,B) (A / B)
+#define FP_DIV_MIX(A,B) ((A) / (B))
 /* Multiply two fixed-point value. */
-#define FP_MULT(A,B) ((fixed_t)(((int64_t) A) * B >> FP_SHIFT_AMOUNT))
+#define FP_MULT(A,B) ((fixed_t)(((int64_t) (A)) * (B) >> FP_SHIFT_AMOUNT))
 /* Divide two fixed-point value. */
-#define FP_DIV(A,B) ((fixed_t)((((int64_t) A) << FP_SHIFT_AMOUNT) / B))
+#define FP_DIV(A,B) ((fixed_t)((((int64_t) (A)) << FP_SHIFT_AMOUNT) / (B)))
 /* Get integer part of a fixed-point value. */
-#define FP_INT_PART(A) (A >> FP_SHIFT_AMOUNT)
+#define FP_INT_PART(A) ((A) >> FP_SHIFT_AMOUNT)
 /* Get rounded integer of a fixed-point value. */
-#define FP_ROUND(A) (A >= 0 ? ((A + (1 << (FP_SHIFT_AMOUNT - 1))) >> FP_SHIFT_AMOUNT) \
-                            : ((A - (1 << (FP_SHIFT_AMOUNT - 1))) >> FP_SHIFT_AMOUNT))
+#define FP_ROUND(A) ((A) >= 0 ? (((A) + (1 << (FP_SHIFT_AMOUNT - 1))) >> FP_SHIFT_AMOUNT) \
+                              : (((A) - (1 << (FP_SHIFT_AMOUNT - 1))) / (1 << FP_SHIFT_AMOUNT)))
 
 #endif /* thread/fixed_point.h */
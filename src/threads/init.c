@@ -15,13 +15,17 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -42,6 +46,8 @@
 #endif
 
 #include "vm/frame.h"
+#include "vm/futex.h"
+#include "vm/page.h"
 #include "vm/swap.h"
 
 /* Page directory with kernel mappings only. */
@@ -110,6 +116,9 @@ int main(void)NO_RETURN;
     palloc_init(user_page_limit);
     malloc_init();
     paging_init();
+    cpu_init();
+    profile_init();
+    trace_init();
 
     /* Segmentation. */
 #ifdef USERPROG
@@ -127,7 +136,9 @@ int main(void)NO_RETURN;
     syscall_init ();
 #endif
     frame_init();
+    page_init();
     swap_init();
+    futex_init();
 
     /* Start thread scheduler and enable interrupts. */
     thread_start();
@@ -262,13 +273,27 @@ parse_options(char **argv) {
             random_init(atoi(value));
         else if (!strcmp(name, "-mlfqs"))
             thread_mlfqs = true;
-#ifdef USERPROG
-            else if (!strcmp (name, "-ul"))
-              user_page_limit = atoi (value);
-#endif
+        else if (!strcmp(name, "-stride"))
+            thread_stride = true;
+        else if (!strcmp(name, "-tickless"))
+            timer_tickless = true;
+        else if (!strcmp(name, "-lockstat"))
+            lock_stat = true;
+        else if (!strcmp(name, "-schedstat"))
+            thread_schedstat = true;
+        else if (!strcmp(name, "-irqoff"))
+            intr_trace = true;
+        else if (!strcmp(name, "-profile"))
+            profile_enabled = true;
+        else if (!strcmp(name, "-trace"))
+            trace_enabled = true;
+        else if (!strcmp(name, "-ul"))
+            user_page_limit = atoi(value);
         else
             PANIC("unknown option `%s' (use -h for help)", name);
     }
+    if (thread_mlfqs && thread_stride)
+        PANIC("-mlfqs and -stride cannot be used together");
 
     /* Initialize the random number generator based on the system
        time.  This has no effect if an "-rs" option was specified.
@@ -380,9 +405,14 @@ usage(void) {
            #endif
            "  -rs=SEED           Set random number seed to SEED.\n"
            "  -mlfqs             Use multi-level feedback queue scheduler.\n"
-#ifdef USERPROG
-            "  -ul=COUNT          Limit user memory to COUNT pages.\n"
-#endif
+           "  -stride            Use stride (proportional-share) scheduler.\n"
+           "  -tickless          Stop the timer interrupt while idle.\n"
+           "  -lockstat          Report lock contention at shutdown.\n"
+           "  -schedstat         Trace scheduler latencies.\n"
+           "  -irqoff            Report the longest interrupts-off windows.\n"
+           "  -profile           Sample the running code on every tick.\n"
+           "  -trace             Record tracepoints, dump them to scratch.\n"
+           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
     );
     shutdown_power_off();
 }
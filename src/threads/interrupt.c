@@ -7,8 +7,13 @@
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
 #include "threads/thread.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/process.h"
+#endif
 
 /* Programmable Interrupt Controller (PIC) registers.
    A PC has two PICs, called the master and slave PICs, with the
@@ -38,15 +43,96 @@ static const char *intr_names[INTR_CNT];
 static unsigned int unexpected_cnt[INTR_CNT];
 
 /* External interrupts are those generated by devices outside the
-   CPU, such as the timer.  External interrupts run with
+   CPU, such as the timer.  External interrupt handlers run with
    interrupts turned off, so they never nest, nor are they ever
-   pre-empted.  Handlers for external interrupts also may not
-   sleep, although they may invoke intr_yield_on_return() to
-   request that a new process be scheduled just before the
-   interrupt returns. */
+   pre-empted.  (Softirqs, below, run with interrupts on, so an
+   external interrupt may arrive during one.)  Handlers for
+   external interrupts also may not sleep, although they may
+   invoke intr_yield_on_return() to request that a new process be
+   scheduled just before the interrupt returns. */
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Time spent in external interrupt handlers proper. */
+static unsigned long long hard_cnt;     /* External interrupts handled. */
+static unsigned long long hard_cycles;  /* Their total length. */
+static uint64_t hard_max_cycles;        /* The longest one. */
+
+/* Bottom halves ("softirqs").
+
+   An external interrupt handler runs with interrupts off, so
+   everything it does adds to the latency of every other
+   interrupt.  A handler can instead raise a softirq, whose
+   function intr_handler() calls after acknowledging the
+   interrupt, with interrupts back on, just before the interrupt
+   returns.  Softirqs still run in interrupt context: on the
+   interrupted thread's stack, unable to sleep, and with
+   intr_context() true, so that wake-ups they do still preempt
+   through intr_yield_on_return().
+
+   An external interrupt that arrives while softirqs run is
+   handled at once but does not run softirqs itself: whatever it
+   raises is picked up by the loop already running, for up to
+   SOFTIRQ_RESTARTS rounds.  Anything left after that waits for
+   the next external interrupt. */
+#define SOFTIRQ_RESTARTS 10
+
+struct softirq {
+    softirq_func *func;                 /* Function to run. */
+    const char *name;                   /* Name, for statistics. */
+    unsigned long long raise_cnt;       /* Times raised. */
+    unsigned long long run_cnt;         /* Times run. */
+    unsigned long long cycles;          /* Total time running. */
+    uint64_t max_cycles;                /* Longest run. */
+};
+
+static struct softirq softirqs[SOFTIRQ_CNT];
+static unsigned softirq_pending;        /* Bit N set: softirq N raised. */
+static bool in_softirq;                 /* Are we running softirqs? */
+static unsigned long long softirq_deferred; /* Left for a later interrupt. */
+
+static void run_softirqs(void);
+
+/* Interrupts-off latency tracing.
+
+   With "-irqoff", every transition of the interrupt flag from on
+   to off is stamped with the TSC and the address of the code that
+   made it, and the next transition back to on measures the window
+   in between.  A window may begin in one thread and end in
+   another, across a context switch, since it is the CPU whose
+   interrupts are off.  Windows opened by the CPU itself, on entry
+   to an interrupt gate, are charged to the interrupt's handler
+   and, when they last until the handler returns, closed at
+   intr_entry.
+
+   The worst windows for each distinct pair of sites are kept for
+   intr_print_stats(), which prints their addresses in a form that
+   utils/backtrace accepts. */
+bool intr_trace;
+
+#define INTR_TRACE_WORST 16             /* Windows kept. */
+
+/* One window, or the worst window for a pair of sites. */
+struct intr_window {
+    void *off_site;                     /* Where interrupts went off. */
+    void *on_site;                      /* Where they came back on. */
+    uint64_t cycles;                    /* TSC cycles in between. */
+};
+
+static struct intr_window worst[INTR_TRACE_WORST]; /* Longest first. */
+static size_t worst_cnt;
+
+static bool off_active;                 /* Is a window open? */
+static void *off_site;                  /* Start of the open window. */
+static uint64_t off_tsc;
+
+static unsigned long long window_cnt;   /* Windows measured. */
+static unsigned long long window_cycles; /* Their total length. */
+
+static void trace_off(void *site);
+
+static void trace_on(void *site);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init(void);
 
@@ -78,18 +164,15 @@ intr_get_level(void) {
     return flags & FLAG_IF ? INTR_ON : INTR_OFF;
 }
 
-/* Enables or disables interrupts as specified by LEVEL and
-   returns the previous interrupt status. */
-enum intr_level
-intr_set_level(enum intr_level level) {
-    return level == INTR_ON ? intr_enable() : intr_disable();
-}
-
-/* Enables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_enable(void) {
+/* Enables interrupts on behalf of the code at SITE and returns
+   the previous interrupt status. */
+static inline enum intr_level
+enable_from(void *site) {
     enum intr_level old_level = intr_get_level();
-    ASSERT(!intr_context());
+    ASSERT(!in_external_intr);
+
+    if (intr_trace && old_level == INTR_OFF)
+        trace_on(site);
 
     /* Enable interrupts by setting the interrupt flag.
 
@@ -100,9 +183,10 @@ intr_enable(void) {
     return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable(void) {
+/* Disables interrupts on behalf of the code at SITE and returns
+   the previous interrupt status. */
+static inline enum intr_level
+disable_from(void *site) {
     enum intr_level old_level = intr_get_level();
 
     /* Disable interrupts by clearing the interrupt flag.
@@ -110,9 +194,44 @@ intr_disable(void) {
        Hardware Interrupts". */
     asm volatile ("cli" : : : "memory");
 
+    if (intr_trace && old_level == INTR_ON)
+        trace_off(site);
+
     return old_level;
 }
 
+/* Enables or disables interrupts as specified by LEVEL and
+   returns the previous interrupt status. */
+enum intr_level
+intr_set_level(enum intr_level level) {
+    void *site = __builtin_return_address(0);
+    return level == INTR_ON ? enable_from(site) : disable_from(site);
+}
+
+/* Enables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_enable(void) {
+    return enable_from(__builtin_return_address(0));
+}
+
+/* Tells the interrupts-off tracer that the caller is about to
+   turn interrupts on with its own "sti", as idle() does to halt
+   atomically, rather than through intr_enable().  Interrupts
+   must be off. */
+void
+intr_trace_sti(void) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (intr_trace)
+        trace_on(__builtin_return_address(0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable(void) {
+    return disable_from(__builtin_return_address(0));
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init(void) {
@@ -202,11 +321,32 @@ intr_register_int(uint8_t vec_no, int dpl, enum intr_level level,
     register_handler(vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt,
+   including its softirqs, and false at all other times. */
 bool
 intr_context(void) {
-    return in_external_intr;
+    return in_external_intr || in_softirq;
+}
+
+/* Registers FUNC, named NAME for statistics, to run as softirq
+   SOFTIRQ. */
+void
+intr_register_softirq(enum softirq_type softirq, softirq_func *func,
+                      const char *name) {
+    ASSERT(softirq < SOFTIRQ_CNT);
+    ASSERT(softirqs[softirq].func == NULL);
+    softirqs[softirq].func = func;
+    softirqs[softirq].name = name;
+}
+
+/* Marks SOFTIRQ pending, to run at the end of the current or next
+   external interrupt.  Interrupts must be off. */
+void
+intr_raise_softirq(enum softirq_type softirq) {
+    ASSERT(softirq < SOFTIRQ_CNT);
+    ASSERT(intr_get_level() == INTR_OFF);
+    softirq_pending |= 1u << softirq;
+    softirqs[softirq].raise_cnt++;
 }
 
 /* During processing of an external interrupt, directs the
@@ -334,23 +474,43 @@ void
 intr_handler(struct intr_frame *frame) {
     bool external;
     intr_handler_func *handler;
+    uint64_t start = 0;
+
+    /* An interrupt gate turned interrupts off on the way in.  If
+       they were on in the interrupted code, any window still open
+       was ended by an "sti" that did not go through enable_from()
+       or intr_trace_sti(), so close it where that code was. */
+    handler = intr_handlers[frame->vec_no];
+    if (intr_trace && intr_get_level() == INTR_OFF) {
+        if (frame->eflags & FLAG_IF)
+            trace_on((void *) frame->eip);
+        trace_off(handler != NULL ? (void *) handler : (void *) intr_handler);
+    }
 
     /* External interrupts are special.
        We only handle one at a time (so interrupts must be off)
        and they need to be acknowledged on the PIC (see below).
-       An external interrupt handler cannot sleep. */
+       An external interrupt handler cannot sleep.  One may arrive
+       while softirqs run, but it leaves softirqs and yielding to
+       the interrupt that started them. */
     external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
     if (external) {
         ASSERT(intr_get_level() == INTR_OFF);
-        ASSERT(!intr_context());
+        ASSERT(!in_external_intr);
 
         in_external_intr = true;
-        yield_on_return = false;
+        start = rdtsc();
+
+        /* While softirqs run, the yield is theirs to make. */
+        if (!in_softirq)
+            yield_on_return = false;
+
+        /* Catch up on ticks that went by in one-shot mode. */
+        timer_intr_enter();
     } else
         thread_current()->user_esp = frame->esp;
 
     /* Invoke the interrupt's handler. */
-    handler = intr_handlers[frame->vec_no];
     if (handler != NULL)
         handler(frame);
     else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
@@ -362,14 +522,166 @@ intr_handler(struct intr_frame *frame) {
 
     /* Complete the processing of an external interrupt. */
     if (external) {
+        uint64_t cycles = rdtsc() - start;
+
         ASSERT(intr_get_level() == INTR_OFF);
         ASSERT(intr_context());
 
+        hard_cnt++;
+        hard_cycles += cycles;
+        if (cycles > hard_max_cycles)
+            hard_max_cycles = cycles;
+
         in_external_intr = false;
         pic_end_of_interrupt(frame->vec_no);
 
-        if (yield_on_return)
-            thread_yield();
+        if (!in_softirq) {
+            if (softirq_pending != 0)
+                run_softirqs();
+            if (yield_on_return)
+                thread_yield();
+        }
+    }
+
+#ifdef USERPROG
+    /* A thread of an exiting process dies on its way back to user
+       mode, however it entered the kernel. */
+    if (frame->cs == SEL_UCSEG)
+        process_check_exit();
+#endif
+
+    /* Returning from the interrupt turns interrupts back on. */
+    if (intr_trace && (frame->eflags & FLAG_IF)
+        && intr_get_level() == INTR_OFF)
+        trace_on(__builtin_return_address(0));
+}
+
+/* Runs pending softirqs with interrupts on, and returns with
+   interrupts off again.  Called at the end of an external
+   interrupt, after acknowledging it. */
+static void
+run_softirqs(void) {
+    int round;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(!in_external_intr && !in_softirq);
+
+    in_softirq = true;
+    for (round = 0; round < SOFTIRQ_RESTARTS && softirq_pending != 0;
+         round++) {
+        unsigned pending = softirq_pending;
+        int i;
+
+        softirq_pending = 0;
+        enable_from((void *) run_softirqs);
+        for (i = 0; i < SOFTIRQ_CNT; i++) {
+            struct softirq *s = &softirqs[i];
+            uint64_t start, cycles;
+
+            if ((pending & (1u << i)) == 0 || s->func == NULL)
+                continue;
+            start = rdtsc();
+            s->func();
+            cycles = rdtsc() - start;
+            s->run_cnt++;
+            s->cycles += cycles;
+            if (cycles > s->max_cycles)
+                s->max_cycles = cycles;
+        }
+        disable_from((void *) run_softirqs);
+    }
+    if (softirq_pending != 0)
+        softirq_deferred++;
+    in_softirq = false;
+}
+
+/* Opens an interrupts-off window at SITE, unless one is open.
+   Interrupts must be off. */
+static void
+trace_off(void *site) {
+    if (!off_active) {
+        off_active = true;
+        off_site = site;
+        off_tsc = rdtsc();
+    }
+}
+
+/* Closes the open interrupts-off window, if any, at SITE and
+   records its length.  Interrupts must be off. */
+static void
+trace_on(void *site) {
+    struct intr_window w;
+    size_t i;
+
+    if (!off_active)
+        return;
+    off_active = false;
+    w.off_site = off_site;
+    w.on_site = site;
+    w.cycles = rdtsc() - off_tsc;
+    window_cnt++;
+    window_cycles += w.cycles;
+
+    /* Keep one entry per pair of sites, its worst window. */
+    for (i = 0; i < worst_cnt; i++)
+        if (worst[i].off_site == w.off_site && worst[i].on_site == w.on_site)
+            break;
+    if (i < worst_cnt) {
+        if (w.cycles <= worst[i].cycles)
+            return;
+    } else if (worst_cnt < INTR_TRACE_WORST)
+        i = worst_cnt++;
+    else if (w.cycles > worst[worst_cnt - 1].cycles)
+        i = worst_cnt - 1;
+    else
+        return;
+
+    /* Move the entry up to its place in order. */
+    for (; i > 0 && worst[i - 1].cycles < w.cycles; i--)
+        worst[i] = worst[i - 1];
+    worst[i] = w;
+}
+
+/* Prints time spent in external interrupt handlers and
+   softirqs, and the worst interrupts-off windows, if tracing. */
+void
+intr_print_stats(void) {
+    size_t i;
+
+    printf("Interrupts: %llu external, %llu cycles avg, "
+           "%"PRIu64" cycles max in handlers\n",
+           hard_cnt, hard_cnt > 0 ? hard_cycles / hard_cnt : 0,
+           hard_max_cycles);
+    for (i = 0; i < SOFTIRQ_CNT; i++) {
+        const struct softirq *s = &softirqs[i];
+        if (s->func != NULL)
+            printf("Softirq %s: %llu raised, %llu runs, %llu cycles avg, "
+                   "%"PRIu64" cycles max\n",
+                   s->name, s->raise_cnt, s->run_cnt,
+                   s->run_cnt > 0 ? s->cycles / s->run_cnt : 0,
+                   s->max_cycles);
+    }
+    if (softirq_deferred > 0)
+        printf("Softirq: %llu times left pending for a later interrupt\n",
+               softirq_deferred);
+
+    if (!intr_trace)
+        return;
+
+    /* Printing turns interrupts off and on, too. */
+    intr_trace = false;
+    printf("Interrupts off: %llu windows, %llu cycles avg\n",
+           window_cnt, window_cnt > 0 ? window_cycles / window_cnt : 0);
+    for (i = 0; i < worst_cnt; i++)
+        printf("Interrupts off: #%zu %llu cycles, off at %p, on at %p\n",
+               i + 1, worst[i].cycles, worst[i].off_site, worst[i].on_site);
+
+    /* For utils/backtrace: each window's off site, then its on site. */
+    if (worst_cnt > 0) {
+        printf("Call stack:");
+        for (i = 0; i < worst_cnt; i++)
+            printf(" %p %p", worst[i].off_site, worst[i].on_site);
+        printf(".\n");
     }
 }
 
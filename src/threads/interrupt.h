@@ -15,6 +15,13 @@ enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
+
+/* If true, trace how long interrupts stay off.
+   Controlled by kernel command-line option "-irqoff". */
+extern bool intr_trace;
+
+void intr_trace_sti (void);
+void intr_print_stats (void);
 
 /* Interrupt stack frame. */
 struct intr_frame
@@ -64,6 +71,21 @@ void intr_register_int (uint8_t vec, int dpl, enum intr_level,
 bool intr_context (void);
 void intr_yield_on_return (void);
 
+/* Bottom halves ("softirqs"): work that an external interrupt
+   handler defers, to run with interrupts on just before the
+   interrupt returns.  See interrupt.c for details. */
+enum softirq_type
+  {
+    SOFTIRQ_TIMER,              /* Timer wheel expiry. */
+    SOFTIRQ_CNT                 /* Number of softirqs. */
+  };
+
+typedef void softirq_func (void);
+
+void intr_register_softirq (enum softirq_type, softirq_func *,
+                            const char *name);
+void intr_raise_softirq (enum softirq_type);
+
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
 
@@ -0,0 +1,196 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/pagedir.h"
+#endif
+
+/* Sampling CPU profiler.
+
+   With "-profile", every timer interrupt records where the CPU
+   was: the interrupted instruction and the return addresses of
+   up to PROFILE_DEPTH - 1 of its callers, found by following the
+   chain of saved frame pointers.  Kernel and user samples go to
+   rings of their own, so that a busy kernel does not crowd the
+   user samples out or the reverse.  Each ring keeps its most
+   recent samples; older ones are overwritten.
+
+   The rings are allocated once, at boot, so that taking a sample
+   never allocates.  Frame pointers are only followed while they
+   stay in memory that is certain to be present: the interrupted
+   thread's kernel stack, or user pages mapped in its page
+   directory.
+
+   At shutdown, profile_dump() prints one line per sample, which
+   utils/profile-fold symbolizes and folds into stacks for a flame
+   graph. */
+bool profile_enabled;
+
+#define PROFILE_PAGES 16        /* Size of both rings together. */
+#define PROFILE_DEPTH 7         /* Most addresses in a sample. */
+
+/* One sample. */
+struct profile_sample
+  {
+    uint32_t pc[PROFILE_DEPTH]; /* Innermost first. */
+    uint32_t depth;             /* Number of valid entries in `pc'. */
+  };
+
+/* A ring of samples. */
+struct profile_ring
+  {
+    const char *name;           /* "kernel" or "user". */
+    char tag;                   /* 'K' or 'U', for profile_dump(). */
+    struct profile_sample *samples;
+    size_t size;                /* Capacity of `samples'. */
+    size_t next;                /* Next slot to overwrite. */
+    unsigned long long cnt;     /* Samples ever taken. */
+  };
+
+static struct profile_ring kernel_ring = { "kernel", 'K', NULL, 0, 0, 0 };
+static struct profile_ring user_ring = { "user", 'U', NULL, 0, 0, 0 };
+
+static size_t walk_kernel (const struct intr_frame *, uint32_t *, size_t);
+static size_t walk_user (const struct intr_frame *, uint32_t *, size_t);
+
+/* Allocates the sample rings, if profiling. */
+void
+profile_init (void)
+{
+  struct profile_sample *samples;
+  size_t cnt;
+
+  if (!profile_enabled)
+    return;
+
+  samples = palloc_get_multiple (0, PROFILE_PAGES);
+  if (samples == NULL)
+    {
+      printf ("profile: no memory for samples, profiling disabled\n");
+      profile_enabled = false;
+      return;
+    }
+  cnt = PROFILE_PAGES * PGSIZE / sizeof *samples;
+  kernel_ring.samples = samples;
+  kernel_ring.size = cnt / 2;
+  user_ring.samples = samples + cnt / 2;
+  user_ring.size = cnt - cnt / 2;
+}
+
+/* Records a sample of the code interrupted by FRAME.
+   Called by the timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *frame)
+{
+  bool user = (frame->cs & 3) != 0;
+  struct profile_ring *r = user ? &user_ring : &kernel_ring;
+  struct profile_sample *s;
+
+  ASSERT (intr_context ());
+  if (r->samples == NULL)
+    return;
+
+  s = &r->samples[r->next];
+  if (++r->next >= r->size)
+    r->next = 0;
+  r->cnt++;
+
+  s->pc[0] = (uint32_t) frame->eip;
+  s->depth = 1 + (user ? walk_user : walk_kernel) (frame, s->pc + 1,
+                                                   PROFILE_DEPTH - 1);
+}
+
+/* Prints every sample kept, oldest first within each ring, as
+   "Profile: K" or "Profile: U" followed by the sample's addresses,
+   innermost first.  Stops profiling. */
+void
+profile_dump (void)
+{
+  struct profile_ring *rings[] = { &kernel_ring, &user_ring };
+  size_t i;
+
+  if (!profile_enabled)
+    return;
+  profile_enabled = false;
+
+  for (i = 0; i < sizeof rings / sizeof *rings; i++)
+    {
+      struct profile_ring *r = rings[i];
+      size_t kept = r->cnt < r->size ? r->cnt : r->size;
+      size_t j;
+
+      printf ("Profile: %llu %s samples, %zu kept\n", r->cnt, r->name, kept);
+      for (j = 0; j < kept; j++)
+        {
+          const struct profile_sample *s
+            = &r->samples[(r->next + r->size - kept + j) % r->size];
+          uint32_t k;
+
+          printf ("Profile: %c", r->tag);
+          for (k = 0; k < s->depth; k++)
+            printf (" 0x%08"PRIx32, s->pc[k]);
+          printf ("\n");
+        }
+    }
+}
+
+/* Stores up to MAX return addresses from the kernel stack that
+   FRAME was pushed on into PCS, innermost first, and returns the
+   number stored. */
+static size_t
+walk_kernel (const struct intr_frame *frame, uint32_t *pcs, size_t max)
+{
+  const uint8_t *stack = pg_round_down (frame);
+  const uint32_t *fp = frame->frame_pointer;
+  size_t n = 0;
+
+  /* Each frame holds the caller's frame pointer, then the return
+     address into the caller.  Frames get older going up. */
+  while (n < max
+         && pg_round_down (fp) == stack
+         && (uintptr_t) fp % sizeof *fp == 0
+         && pg_ofs (fp) <= PGSIZE - 2 * sizeof *fp
+         && fp[1] != 0)
+    {
+      pcs[n++] = fp[1];
+      if ((const uint32_t *) fp[0] <= fp)
+        break;
+      fp = (const uint32_t *) fp[0];
+    }
+  return n;
+}
+
+/* Stores up to MAX return addresses from the user stack of the
+   process interrupted by FRAME into PCS, innermost first, and
+   returns the number stored. */
+static size_t
+walk_user (const struct intr_frame *frame UNUSED, uint32_t *pcs UNUSED,
+           size_t max UNUSED)
+{
+  size_t n = 0;
+#ifdef USERPROG
+  uint32_t *pd = thread_current ()->pagedir;
+  uintptr_t fp = (uintptr_t) frame->frame_pointer;
+
+  while (pd != NULL && n < max
+         && is_user_vaddr ((void *) fp)
+         && fp % sizeof (uint32_t) == 0
+         && pg_ofs ((void *) fp) <= PGSIZE - 2 * sizeof (uint32_t))
+    {
+      const uint32_t *kfp = pagedir_get_page (pd, (void *) fp);
+      if (kfp == NULL || kfp[1] == 0)
+        break;
+      pcs[n++] = kfp[1];
+      if (kfp[0] <= fp)
+        break;
+      fp = kfp[0];
+    }
+#endif
+  return n;
+}
@@ -0,0 +1,241 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* An object cache allocator for small, fixed-size kernel objects.
+
+   malloc() rounds every request up to a power of 2 and serves
+   all callers of a given size class from one descriptor under
+   one lock.  Objects that are allocated and freed at a high rate
+   and always have the same size, such as the VM's struct page,
+   are better served by a cache of their own.
+
+   Each cache obtains whole pages, called "slabs", from the page
+   allocator.  A slab begins with a small header and is divided
+   into as many objects of exactly the cache's object size as
+   will fit.  Free objects in a slab are chained through their
+   first word.  The cache keeps a list of slabs that have at
+   least one free object, so allocation and freeing take
+   constant time.
+
+   When the last object in a slab is freed, the slab is kept as
+   the cache's spare if it has none, so that alternating
+   alloc/free of a single object doesn't bounce a page to and
+   from the page allocator; otherwise it is returned to the page
+   allocator. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Slab header, at the beginning of each slab page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's `partial' list. */
+    void *free;                 /* First free object, or null. */
+    size_t in_use;              /* Number of allocated objects. */
+  };
+
+/* All object caches, for slab_print_stats(). */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *slab_create (struct slab_cache *);
+static struct slab *obj_to_slab (void *);
+
+/* Initializes CACHE to hand out objects of SIZE bytes, naming it
+   NAME for statistics.  Caches are expected to be set up during
+   boot, before other threads are running. */
+void
+slab_cache_init (struct slab_cache *cache, const char *name, size_t size)
+{
+  enum intr_level old_level;
+
+  ASSERT (cache != NULL);
+  ASSERT (name != NULL);
+  ASSERT (size > 0);
+
+  /* Free objects hold a pointer to the next free object, and
+     every object must stay suitably aligned for it. */
+  if (size < sizeof (void *))
+    size = sizeof (void *);
+  size = ROUND_UP (size, sizeof (void *));
+  ASSERT (size <= PGSIZE - sizeof (struct slab));
+
+  cache->name = name;
+  cache->obj_size = size;
+  cache->objs_per_slab = (PGSIZE - sizeof (struct slab)) / size;
+  list_init (&cache->partial);
+  cache->spare = NULL;
+  lock_init (&cache->lock);
+  lock_set_name (&cache->lock, name);
+  cache->alloc_cnt = cache->free_cnt = 0;
+  cache->slab_cnt = cache->slab_peak = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &cache->elem);
+  intr_set_level (old_level);
+}
+
+/* Obtains and returns a new object from CACHE.
+   Returns a null pointer if memory is not available.
+   The object's contents are unspecified. */
+void *
+slab_alloc (struct slab_cache *cache)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&cache->lock);
+  if (list_empty (&cache->partial))
+    {
+      /* Use the spare slab, if any, or obtain a new one. */
+      s = cache->spare;
+      if (s != NULL)
+        cache->spare = NULL;
+      else
+        {
+          s = slab_create (cache);
+          if (s == NULL)
+            {
+              lock_release (&cache->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&cache->partial, &s->elem);
+    }
+  else
+    s = list_entry (list_front (&cache->partial), struct slab, elem);
+
+  /* Take an object off the slab's free list.  A slab with no
+     free objects left is not on the `partial' list. */
+  obj = s->free;
+  s->free = *(void **) obj;
+  s->in_use++;
+  if (s->free == NULL)
+    list_remove (&s->elem);
+  cache->alloc_cnt++;
+  lock_release (&cache->lock);
+
+  return obj;
+}
+
+/* Returns OBJ, which must have been obtained from CACHE with
+   slab_alloc(), to CACHE.  A null OBJ is ignored. */
+void
+slab_free (struct slab_cache *cache, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (obj);
+  ASSERT (s->cache == cache);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs. */
+  memset (obj, 0xcc, cache->obj_size);
+#endif
+
+  lock_acquire (&cache->lock);
+  ASSERT (s->in_use > 0);
+
+  /* A full slab becomes partial again. */
+  if (s->free == NULL)
+    list_push_front (&cache->partial, &s->elem);
+  *(void **) obj = s->free;
+  s->free = obj;
+  s->in_use--;
+  cache->free_cnt++;
+
+  /* Keep one empty slab around, give any other back. */
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (cache->spare == NULL)
+        cache->spare = s;
+      else
+        {
+          cache->slab_cnt--;
+          s->magic = 0;
+          palloc_free_page (s);
+        }
+    }
+  lock_release (&cache->lock);
+}
+
+/* Prints statistics for every object cache. */
+void
+slab_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, elem);
+      printf ("Slab %s: %zu-byte objects, %zu per slab, "
+              "%llu allocs, %llu frees, %lu slabs (peak %lu)\n",
+              c->name, c->obj_size, c->objs_per_slab,
+              c->alloc_cnt, c->free_cnt, c->slab_cnt, c->slab_peak);
+    }
+}
+
+/* Obtains a new slab for CACHE from the page allocator and
+   threads all of its objects onto its free list.
+   Returns the slab, or a null pointer if no page is available.
+   CACHE's lock must be held. */
+static struct slab *
+slab_create (struct slab_cache *cache)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&cache->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->free = NULL;
+  s->in_use = 0;
+
+  /* Chain the objects so that the lowest address is handed out
+     first. */
+  obj = (uint8_t *) (s + 1) + (cache->objs_per_slab - 1) * cache->obj_size;
+  for (i = 0; i < cache->objs_per_slab; i++, obj -= cache->obj_size)
+    {
+      *(void **) obj = s->free;
+      s->free = obj;
+    }
+
+  if (++cache->slab_cnt > cache->slab_peak)
+    cache->slab_peak = cache->slab_cnt;
+  return s;
+}
+
+/* Returns the slab that object OBJ is inside. */
+static struct slab *
+obj_to_slab (void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid. */
+  ASSERT (s != NULL);
+  ASSERT (s->magic == SLAB_MAGIC);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - sizeof *s) % s->cache->obj_size == 0);
+
+  return s;
+}
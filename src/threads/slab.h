@@ -0,0 +1,32 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* An object cache: a pool of fixed-size objects carved out of
+   whole pages ("slabs").  See slab.c for details. */
+struct slab_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Size of each object in bytes. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    struct list partial;        /* Slabs with at least one free object. */
+    struct slab *spare;         /* One completely free slab, or null. */
+    struct lock lock;           /* Protects all of the above. */
+    struct list_elem elem;      /* Element in list of all caches. */
+
+    /* Statistics. */
+    unsigned long long alloc_cnt;       /* Objects handed out. */
+    unsigned long long free_cnt;        /* Objects given back. */
+    unsigned long slab_cnt;             /* Slabs currently owned. */
+    unsigned long slab_peak;            /* Most slabs ever owned. */
+  };
+
+void slab_cache_init (struct slab_cache *, const char *name, size_t size);
+void *slab_alloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
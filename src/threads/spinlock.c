@@ -0,0 +1,86 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+
+/* Spinlocks.
+
+   A lock or semaphore puts a waiter to sleep, which takes a trip
+   through the scheduler and cannot be done from an interrupt
+   handler.  Short critical sections that never sleep, such as
+   those that only update a few counters or a small array, are
+   better served by a spinlock: a waiter busy-waits on the lock
+   word until the holder releases it.
+
+   Interrupts stay disabled for as long as a spinlock is held, so
+   that an interrupt handler on the same CPU cannot try to take a
+   lock that the code it interrupted already holds.  With only
+   one CPU running kernel code the lock word is therefore never
+   found set, and a spinlock costs little more than the
+   intr_disable() it replaces; the atomic exchange is what keeps
+   the same critical section correct once other CPUs run too.
+
+   Spinlocks do not nest recursively, and code holding one must
+   not sleep. */
+
+/* Atomically stores NEW into *WORD and returns its old value. */
+static inline uint32_t
+xchg (volatile uint32_t *word, uint32_t new)
+{
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*word) : : "memory");
+  return new;
+}
+
+/* Initializes LOCK as free. */
+void
+spinlock_init (struct spinlock *lock)
+{
+  ASSERT (lock != NULL);
+
+  lock->locked = 0;
+  lock->cpu = NULL;
+  lock->old_level = INTR_OFF;
+}
+
+/* Disables interrupts and acquires LOCK, spinning until it is
+   free.  LOCK must not already be held by the current CPU.
+   May be called from an interrupt handler. */
+void
+spinlock_acquire (struct spinlock *lock)
+{
+  enum intr_level old_level;
+
+  ASSERT (lock != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (!spinlock_held_by_current_cpu (lock));
+  while (xchg (&lock->locked, 1) != 0)
+    while (lock->locked)
+      asm volatile ("pause");
+  lock->cpu = cpu_current ();
+  lock->old_level = old_level;
+}
+
+/* Releases LOCK, which must be held by the current CPU, and
+   restores the interrupt level from before it was acquired. */
+void
+spinlock_release (struct spinlock *lock)
+{
+  enum intr_level old_level;
+
+  ASSERT (spinlock_held_by_current_cpu (lock));
+
+  old_level = lock->old_level;
+  lock->cpu = NULL;
+  xchg (&lock->locked, 0);
+  intr_set_level (old_level);
+}
+
+/* Returns true if the current CPU holds LOCK, false otherwise. */
+bool
+spinlock_held_by_current_cpu (const struct spinlock *lock)
+{
+  ASSERT (lock != NULL);
+
+  return lock->locked && lock->cpu == cpu_current ();
+}
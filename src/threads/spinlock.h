@@ -0,0 +1,27 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+struct cpu;
+
+/* A spinlock, for short critical sections that never sleep.
+   See spinlock.c for details. */
+struct spinlock
+  {
+    volatile uint32_t locked;   /* 1 if held, 0 if free. */
+    struct cpu *cpu;            /* CPU holding the lock, or null. */
+    enum intr_level old_level;  /* Interrupt level before acquiring. */
+  };
+
+/* Initializer for a spinlock with static storage duration. */
+#define SPINLOCK_INITIALIZER { 0, NULL, INTR_OFF }
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held_by_current_cpu (const struct spinlock *);
+
+#endif /* threads/spinlock.h */
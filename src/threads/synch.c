@@ -27,10 +27,31 @@
 */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/tsc.h"
+
+/* Longest chain of nested locks that priority is donated
+   through.  Bounds the time spent with interrupts off. */
+#define DONATION_DEPTH_MAX 8
+
+static bool priority_less (const struct list_elem *,
+                           const struct list_elem *, void *aux);
+static int waiters_max_priority (const struct semaphore *);
+static void donate_priority (struct thread *);
+static void rwlock_wake (struct rwlock *);
+static bool wait_more (const struct list_elem *, const struct list_elem *,
+                       void *aux);
+
+/* If true, named locks keep contention statistics.
+   Controlled by kernel command-line option "-lockstat". */
+bool lock_stat;
+
+/* All locks given a name by lock_set_name(). */
+static struct list named_locks = LIST_INITIALIZER (named_locks);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -102,7 +123,9 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any.  Waiters of equal priority are woken in FIFO
+   order.
 
    This function may be called from an interrupt handler. */
 void
@@ -114,10 +137,16 @@ sema_up (struct semaphore *sema)
 
   old_level = intr_disable ();
   if (!list_empty (&sema->waiters)) 
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
+    {
+      struct list_elem *e = list_max (&sema->waiters, priority_less, NULL);
+      list_remove (e);
+      thread_unblock (list_entry (e, struct thread, elem));
+    }
   sema->value++;
   intr_set_level (old_level);
+
+  /* Let a woken thread of higher priority run right away. */
+  thread_preempt ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -171,7 +200,14 @@ sema_test_helper (void *sema_)
    another one "up" it, but with a lock the same thread must both
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   instead of a lock.
+
+   Unless the MLFQS scheduler is in use, a thread that waits for
+   a lock donates its priority to the lock's holder, and onward
+   along the chain of locks the holder is itself waiting for, so
+   that a low-priority holder cannot starve a high-priority
+   waiter.  The donation lasts until the holder releases the
+   lock. */
 void
 lock_init (struct lock *lock)
 {
@@ -179,6 +215,30 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+  lock->max_priority = PRI_MIN;
+  lock->name = NULL;
+}
+
+/* Names LOCK, so that with -lockstat its contention statistics
+   are kept and reported by lock_print_stats().  LOCK must never
+   be freed afterward, because it stays on the list of named
+   locks, and NAME must stay valid as long as LOCK. */
+void
+lock_set_name (struct lock *lock, const char *name)
+{
+  enum intr_level old_level;
+
+  ASSERT (lock != NULL);
+  ASSERT (lock->name == NULL);
+  ASSERT (name != NULL);
+
+  lock->name = name;
+  lock->acquire_cnt = lock->contended_cnt = 0;
+  lock->wait_cycles = lock->wait_max = lock->hold_max = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&named_locks, &lock->all_elem);
+  intr_set_level (old_level);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -192,12 +252,47 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  struct thread *cur = thread_current ();
+  bool stat = lock_stat && lock->name != NULL;
+  enum intr_level old_level;
+  uint64_t start = 0;
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  if (stat)
+    {
+      start = rdtsc ();
+      if (lock->holder != NULL)
+        lock->contended_cnt++;
+    }
+  if (lock->holder != NULL && !thread_mlfqs)
+    {
+      cur->wait_lock = lock;
+      donate_priority (cur);
+    }
   sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+  cur->wait_lock = NULL;
+  if (stat)
+    {
+      uint64_t now = rdtsc ();
+      uint64_t wait = now - start;
+
+      lock->acquire_cnt++;
+      lock->wait_cycles += wait;
+      if (wait > lock->wait_max)
+        lock->wait_max = wait;
+      lock->hold_start = now;
+    }
+
+  /* Threads still waiting now donate to us instead. */
+  lock->holder = cur;
+  lock->max_priority = waiters_max_priority (&lock->semaphore);
+  list_push_back (&cur->locks, &lock->elem);
+  thread_update_priority (cur);
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -209,14 +304,29 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      struct thread *cur = thread_current ();
+
+      lock->holder = cur;
+      lock->max_priority = waiters_max_priority (&lock->semaphore);
+      list_push_back (&cur->locks, &lock->elem);
+      thread_update_priority (cur);
+      if (lock_stat && lock->name != NULL)
+        {
+          lock->acquire_cnt++;
+          lock->hold_start = rdtsc ();
+        }
+    }
+  intr_set_level (old_level);
   return success;
 }
 
@@ -228,13 +338,69 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  /* Drop whatever was donated through LOCK. */
+  old_level = intr_disable ();
+  if (lock_stat && lock->name != NULL)
+    {
+      uint64_t hold = rdtsc () - lock->hold_start;
+      if (hold > lock->hold_max)
+        lock->hold_max = hold;
+    }
+  list_remove (&lock->elem);
   lock->holder = NULL;
+  lock->max_priority = PRI_MIN;
+  thread_update_priority (thread_current ());
+  intr_set_level (old_level);
+
   sema_up (&lock->semaphore);
 }
 
+/* Prints contention statistics for every named lock that has
+   been acquired, most total waiting first. */
+void
+lock_print_stats (void)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+
+  if (!lock_stat)
+    return;
+
+  old_level = intr_disable ();
+  list_sort (&named_locks, wait_more, NULL);
+  intr_set_level (old_level);
+
+  printf ("Lock: %-16s %10s %10s %14s %12s %12s\n", "name", "acquired",
+          "contended", "wait cycles", "max wait", "max hold");
+  for (e = list_begin (&named_locks); e != list_end (&named_locks);
+       e = list_next (e))
+    {
+      struct lock *l = list_entry (e, struct lock, all_elem);
+      if (l->acquire_cnt == 0)
+        continue;
+      printf ("Lock: %-16s %10llu %10llu %14"PRIu64" %12"PRIu64
+              " %12"PRIu64"\n", l->name, l->acquire_cnt, l->contended_cnt,
+              l->wait_cycles, l->wait_max, l->hold_max);
+    }
+}
+
+/* Returns true if lock A_ has spent more time waited for than
+   lock B_. */
+static bool
+wait_more (const struct list_elem *a_, const struct list_elem *b_,
+           void *aux UNUSED)
+{
+  const struct lock *a = list_entry (a_, struct lock, all_elem);
+  const struct lock *b = list_entry (b_, struct lock, all_elem);
+
+  return a->wait_cycles > b->wait_cycles;
+}
+
 /* Returns true if the current thread holds LOCK, false
    otherwise.  (Note that testing whether some other thread holds
    a lock would be racy.) */
@@ -246,13 +412,65 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
+/* Donates T's priority to the holder of the lock T is waiting
+   for, then to the holder of the lock that thread is waiting
+   for, and so on, up to DONATION_DEPTH_MAX locks deep.
+   Interrupts must be off. */
+static void
+donate_priority (struct thread *t)
+{
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (depth = 0; depth < DONATION_DEPTH_MAX; depth++)
+    {
+      struct lock *lock = t->wait_lock;
+
+      if (lock == NULL || lock->holder == NULL
+          || lock->max_priority >= t->priority)
+        break;
+      lock->max_priority = t->priority;
+      t = lock->holder;
+      thread_update_priority (t);
+    }
+}
+
+/* Returns the highest priority among threads waiting for SEMA,
+   or PRI_MIN if there are none.  Interrupts must be off. */
+static int
+waiters_max_priority (const struct semaphore *sema)
+{
+  struct list *waiters = (struct list *) &sema->waiters;
+
+  if (list_empty (waiters))
+    return PRI_MIN;
+  return list_entry (list_max (waiters, priority_less, NULL),
+                     struct thread, elem)->priority;
+}
+
+/* Returns true if thread A_ has lower priority than thread B_. */
+static bool
+priority_less (const struct list_elem *a_, const struct list_elem *b_,
+               void *aux UNUSED)
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->priority < b->priority;
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem 
   {
     struct list_elem elem;              /* List element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
+static bool cond_priority_less (const struct list_elem *,
+                                const struct list_elem *, void *aux);
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -295,6 +513,7 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
+  waiter.thread = thread_current ();
   list_push_back (&cond->waiters, &waiter.elem);
   lock_release (lock);
   sema_down (&waiter.semaphore);
@@ -302,7 +521,8 @@ cond_wait (struct condition *cond, struct lock *lock)
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
+   this function signals the highest-priority one of them to
+   wake up from its wait.
    LOCK must be held before calling this function.
 
    An interrupt handler cannot acquire a lock, so it does not
@@ -317,8 +537,26 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (lock_held_by_current_thread (lock));
 
   if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+    {
+      struct list_elem *e = list_max (&cond->waiters, cond_priority_less,
+                                      NULL);
+      list_remove (e);
+      sema_up (&list_entry (e, struct semaphore_elem, elem)->semaphore);
+    }
+}
+
+/* Returns true if the thread waiting on semaphore_elem A_ has
+   lower priority than the one waiting on B_. */
+static bool
+cond_priority_less (const struct list_elem *a_, const struct list_elem *b_,
+                    void *aux UNUSED)
+{
+  const struct semaphore_elem *a = list_entry (a_, struct semaphore_elem,
+                                               elem);
+  const struct semaphore_elem *b = list_entry (b_, struct semaphore_elem,
+                                               elem);
+
+  return a->thread->priority < b->thread->priority;
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -336,3 +574,158 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW.  A reader-writer lock may be held by any
+   number of readers at once, or by a single writer.
+
+   The lock prefers writers: once a writer is waiting, new readers
+   wait too, so that a steady stream of readers cannot starve
+   writers.  When the lock becomes free, it is handed directly to
+   the highest-priority waiting writer, unless a waiting reader
+   has higher priority still, in which case every waiting reader
+   is let in together.  Readers are not tracked individually, so
+   unlike a lock, a reader-writer lock does not donate
+   priority. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  rw->readers = 0;
+  rw->writer = NULL;
+  list_init (&rw->read_waiters);
+  list_init (&rw->write_waiters);
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it or
+   is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rw));
+
+  old_level = intr_disable ();
+  if (rw->writer == NULL && list_empty (&rw->write_waiters))
+    rw->readers++;
+  else
+    {
+      /* rwlock_wake() counts us in before waking us. */
+      list_push_back (&rw->read_waiters, &thread_current ()->elem);
+      thread_block ();
+    }
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for
+   reading. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (rw->readers > 0);
+  if (--rw->readers == 0)
+    rwlock_wake (rw);
+  intr_set_level (old_level);
+
+  thread_preempt ();
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rw));
+
+  old_level = intr_disable ();
+  if (rw->writer == NULL && rw->readers == 0)
+    rw->writer = cur;
+  else
+    {
+      /* rwlock_wake() makes us the writer before waking us. */
+      list_push_back (&rw->write_waiters, &cur->elem);
+      thread_block ();
+    }
+  ASSERT (rw->writer == cur);
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for
+   writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_for_write (rw));
+
+  old_level = intr_disable ();
+  rw->writer = NULL;
+  rwlock_wake (rw);
+  intr_set_level (old_level);
+
+  thread_preempt ();
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_for_write (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* Hands RW, which nobody holds, to the waiting writer or readers
+   that should have it next, as described at rwlock_init().
+   Interrupts must be off. */
+static void
+rwlock_wake (struct rwlock *rw)
+{
+  struct list_elem *w, *r;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (rw->writer == NULL && rw->readers == 0);
+
+  if (!list_empty (&rw->write_waiters))
+    {
+      w = list_max (&rw->write_waiters, priority_less, NULL);
+      if (list_empty (&rw->read_waiters)
+          || !priority_less (w, list_max (&rw->read_waiters, priority_less,
+                                          NULL), NULL))
+        {
+          list_remove (w);
+          rw->writer = list_entry (w, struct thread, elem);
+          thread_unblock (rw->writer);
+          return;
+        }
+    }
+
+  while (!list_empty (&rw->read_waiters))
+    {
+      r = list_pop_front (&rw->read_waiters);
+      rw->readers++;
+      thread_unblock (list_entry (r, struct thread, elem));
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
@@ -22,9 +23,26 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    int max_priority;           /* Highest priority donated by a waiter. */
+    struct list_elem elem;      /* Element in holder's `locks' list. */
+
+    /* Contention statistics, kept for named locks with -lockstat. */
+    const char *name;           /* Name, or null if not tracked. */
+    struct list_elem all_elem;  /* Element in list of named locks. */
+    unsigned long long acquire_cnt;     /* Times acquired. */
+    unsigned long long contended_cnt;   /* Times found held by another. */
+    uint64_t wait_cycles;       /* Total TSC cycles spent waiting. */
+    uint64_t wait_max;          /* Longest wait, in TSC cycles. */
+    uint64_t hold_start;        /* TSC when last acquired. */
+    uint64_t hold_max;          /* Longest hold, in TSC cycles. */
   };
 
+/* Lock contention statistics. */
+extern bool lock_stat;
+
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
+void lock_print_stats (void);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -41,6 +59,22 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock
+  {
+    unsigned readers;           /* Number of readers holding the lock. */
+    struct thread *writer;      /* Writer holding the lock, or null. */
+    struct list read_waiters;   /* Threads waiting to read. */
+    struct list write_waiters;  /* Threads waiting to write. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
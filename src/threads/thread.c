@@ -1,15 +1,23 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <random.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/fixed_point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/spinlock.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 #include "userprog/syscall.h"
 #ifdef USERPROG
@@ -21,22 +29,74 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queues of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO queue per priority, and bit P of ready_mask
+   is set iff ready_queues[P] is nonempty, so the highest-priority
+   ready thread is found with a find-first-set instead of a scan. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint32_t ready_mask[(PRI_MAX + 32) / 32];
+static int ready_cnt;           /* # of threads in the run queues. */
+
+/* Under the stride scheduler, ready threads are instead kept in
+   a binary min-heap ordered by pass, and the thread with the
+   lowest pass runs next.  Each tick charges the running thread
+   its stride, which is inversely proportional to its tickets, so
+   over time each thread runs in proportion to its tickets.
+   Every thread but the idle thread can be ready at once, so
+   thread_create() refuses to make more threads than fit. */
+#define STRIDE1 (1 << 20)       /* Stride of a thread with 1 ticket. */
+#define STRIDE_HEAP_MAX 1024    /* Most threads under -stride. */
+static struct thread *stride_heap[STRIDE_HEAP_MAX];
+static size_t stride_cnt;       /* # of threads in stride_heap. */
+static int64_t global_pass;     /* Pass of the last thread picked. */
+static unsigned thread_cnt;     /* # of threads in existence. */
+
+/* Pages of recently exited threads, kept for reuse by
+   thread_create() so that creating a thread usually does not
+   need the page allocator.  A recycled page is not cleared as a
+   whole: init_thread() clears struct thread and alloc_frame()
+   clears each frame built on the new stack, and the rest of the
+   stack is never read before it is written. */
+#define THREAD_CACHE_MAX 16
+static struct thread *thread_cache[THREAD_CACHE_MAX];
+static size_t thread_cache_cnt;
+static long long thread_cache_hits;     /* Pages reused. */
+static long long thread_cache_misses;   /* Pages from palloc. */
+static struct spinlock thread_cache_lock = SPINLOCK_INITIALIZER;
+
+/* Earliest-deadline-first class for periodic threads.
+
+   A thread joins with thread_set_periodic(), which reserves
+   BUDGET ticks of CPU in every PERIOD ticks for it.  Admission
+   control keeps the total reservation within RT_UTIL_MAX, which
+   under EDF guarantees every deadline can be met while leaving
+   the rest of the CPU to the normal class.  A job's deadline is
+   the end of its period.
+
+   Ready real-time threads run ahead of every other thread, in
+   order of deadline.  A thread that uses up its budget is
+   throttled: it is taken off the CPU until its next period
+   begins, so an overrunning thread cannot break the others'
+   guarantees.  thread_tick() replenishes budgets and starts new
+   periods, counting a deadline miss for each job that was not
+   finished with thread_wait_period() by the end of its period. */
+static struct list rt_ready_list;       /* Ready threads by deadline. */
+static struct list rt_threads;          /* All real-time threads. */
+static int rt_util_total;               /* Sum of reservations. */
+static int64_t rt_next_release = INT64_MAX; /* Earliest rt_deadline. */
+static unsigned rt_admitted;            /* # of admissions, ever. */
+static unsigned long long rt_misses;    /* Deadlines missed, all threads. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 struct list all_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+/* Spinlock used by allocate_tid(). */
+static struct spinlock tid_lock = SPINLOCK_INITIALIZER;
 
 struct lock filesys_lock;
 
@@ -47,20 +107,59 @@ struct kernel_thread_frame {
     void *aux;                  /* Auxiliary data for function. */
 };
 
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
-
-/* Scheduling. */
+/* Scheduling.  The idle thread, the running thread's time slice
+   and the tick statistics are kept per CPU in struct cpu. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+bool thread_stride;
+
+/* Scheduler latency tracing.
+
+   With "-schedstat", schedule() and thread_schedule_tail()
+   timestamp every context switch with the TSC.  A thread's wait
+   from becoming ready to running is recorded in one of two
+   histograms, depending on whether thread_unblock() woke it or
+   it was preempted or yielded.  How long it then ran is recorded
+   in a third.  Each thread counts its own voluntary and
+   involuntary switches and its time on the CPU.  The idle thread
+   is left out. */
+bool thread_schedstat;
+static struct schedstat sched_stats;    /* System-wide part only. */
+
+/* 4.4BSD scheduler.
+
+   A thread's priority depends only on its nice value and its
+   recent_cpu.  Between once-a-second updates, recent_cpu only
+   changes for the running thread, so every fourth tick only the
+   running thread's priority is recomputed.
+
+   Once a second every thread's recent_cpu decays by a factor
+   that depends on the load average.  Only the running thread
+   and the threads in the run queues, whose priorities decide
+   what runs next, are updated then.  A blocked thread's nice
+   value and recent_cpu cannot change while it sleeps, so it
+   catches up in thread_unblock() by applying the decay factors
+   recorded for the seconds it missed.  Factors are kept for the
+   last DECAY_HISTORY seconds; a thread that slept longer starts
+   from the steady-state recent_cpu for the oldest factor. */
+#define DECAY_HISTORY 64
+static fixed_t load_avg;                        /* System load average. */
+static int64_t mlfqs_sec;                       /* Seconds since boot. */
+static fixed_t decay_history[DECAY_HISTORY];    /* Per-second decay factors. */
+
+/* Cost of the 4.4BSD bookkeeping in the timer interrupt. */
+static uint64_t mlfqs_tick_cycles;      /* Total cycles, all ticks. */
+static uint64_t mlfqs_tick_max;         /* Most cycles in one tick. */
+static uint64_t mlfqs_sec_max;          /* Most cycles in a once-a-second update. */
+static unsigned mlfqs_sec_max_threads;  /* Threads updated in that update. */
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -69,6 +168,41 @@ static struct thread *running_thread(void);
 
 static struct thread *next_thread_to_run(void);
 
+static void ready_push(struct thread *);
+
+static void ready_remove(struct thread *);
+
+static int ready_max_priority(void);
+
+static void stride_push(struct thread *);
+
+static struct thread *stride_pop(void);
+
+static bool ready_preempts(struct thread *);
+
+static bool rt_active(const struct thread *);
+
+static bool deadline_less(const struct list_elem *, const struct list_elem *,
+                          void *aux);
+
+static void rt_release(int64_t now);
+
+static void rt_leave(struct thread *);
+
+static void mlfqs_tick(void);
+
+static unsigned mlfqs_second(void);
+
+static void mlfqs_update(struct thread *);
+
+static void sched_switch_out(struct thread *);
+
+static void sched_switch_in(struct thread *);
+
+static void sched_hist_add(enum schedstat_hist, uint64_t cycles);
+
+static void sched_hist_print(enum schedstat_hist, const char *what);
+
 static void init_thread(struct thread *, const char *name, int priority);
 
 static bool is_thread(struct thread *)UNUSED;
@@ -90,13 +224,18 @@ static bool is_thread(struct thread *)UNUSED;
         void
         thread_init(void)
 {
+    int i;
+
     ASSERT(intr_get_level() == INTR_OFF);
 
-    lock_init(&tid_lock);
-    list_init(&ready_list);
+    for (i = 0; i <= PRI_MAX; i++)
+        list_init(&ready_queues[i]);
+    list_init(&rt_ready_list);
+    list_init(&rt_threads);
     list_init(&all_list);
 
     lock_init(&filesys_lock);
+    lock_set_name(&filesys_lock, "filesys");
 
     /* Set up a thread structure for the running thread. */
     initial_thread = running_thread();
@@ -127,27 +266,271 @@ thread_start(void) {
 void
 thread_tick(void) {
     struct thread *t = thread_current();
+    struct cpu *c = cpu_current();
 
     /* Update statistics. */
-    if (t == idle_thread)
-        idle_ticks++;
+    if (t == c->idle_thread)
+        c->idle_ticks++;
 #ifdef USERPROG
         else if (t->pagedir != NULL)
-    user_ticks++;
+    c->user_ticks++;
 #endif
     else
-        kernel_ticks++;
+        c->kernel_ticks++;
+
+    if (thread_mlfqs)
+        mlfqs_tick();
+    else if (thread_stride && t != c->idle_thread)
+        t->pass += t->stride;
+
+    /* Enforce real-time budgets and start new periods. */
+    if (rt_active(t) && ++t->rt_used >= t->rt_budget) {
+        t->rt_throttled = true;
+        intr_yield_on_return();
+    }
+    if (timer_ticks() >= rt_next_release)
+        rt_release(timer_ticks());
 
     /* Enforce preemption. */
-    if (++thread_ticks >= TIME_SLICE)
+    if (++c->thread_ticks >= TIME_SLICE)
         intr_yield_on_return();
 }
 
 /* Prints thread statistics. */
 void
 thread_print_stats(void) {
+    long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+    unsigned i;
+
+    for (i = 0; i < cpu_cnt; i++) {
+        idle_ticks += cpus[i].idle_ticks;
+        kernel_ticks += cpus[i].kernel_ticks;
+        user_ticks += cpus[i].user_ticks;
+    }
     printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
            idle_ticks, kernel_ticks, user_ticks);
+    if (thread_mlfqs) {
+        long long ticks = idle_ticks + kernel_ticks + user_ticks;
+        printf("Thread: mlfqs tick cost %llu cycles avg, %llu max; "
+               "per-second update %llu cycles max (%u threads)\n",
+               ticks > 0 ? mlfqs_tick_cycles / ticks : 0, mlfqs_tick_max,
+               mlfqs_sec_max, mlfqs_sec_max_threads);
+    }
+    printf("Thread: %lld pages reused from thread cache, %lld allocated\n",
+           thread_cache_hits, thread_cache_misses);
+    if (rt_admitted > 0)
+        printf("Thread: %u real-time admissions, %llu deadline misses\n",
+               rt_admitted, rt_misses);
+    if (thread_schedstat) {
+        printf("Thread: %llu voluntary, %llu involuntary context switches\n",
+               sched_stats.sys_voluntary, sched_stats.sys_involuntary);
+        sched_hist_print(SCHEDSTAT_WAKEUP, "wakeup-to-run latency");
+        sched_hist_print(SCHEDSTAT_REQUEUE, "preempted-to-run latency");
+        sched_hist_print(SCHEDSTAT_RUN, "time on CPU per switch");
+    }
+}
+
+/* Copies the system-wide scheduler statistics and the running
+   thread's own counters into STATS.  The counters are only kept
+   under "-schedstat", so returns false without touching STATS
+   otherwise. */
+bool
+thread_get_schedstat(struct schedstat *stats) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    if (!thread_schedstat)
+        return false;
+
+    old_level = intr_disable();
+
+    *stats = sched_stats;
+    stats->voluntary = cur->voluntary;
+    stats->involuntary = cur->involuntary;
+    stats->cpu_cycles = cur->cpu_cycles + (rdtsc() - cur->run_tsc);
+    intr_set_level(old_level);
+    return true;
+}
+
+/* Accounts for running thread CUR being switched out, having
+   already been given its new status.  Interrupts must be off. */
+static void
+sched_switch_out(struct thread *cur) {
+    uint64_t now = rdtsc();
+    uint64_t ran = now - cur->run_tsc;
+
+    if (cur == cpu_current()->idle_thread)
+        return;
+    cur->cpu_cycles += ran;
+    sched_hist_add(SCHEDSTAT_RUN, ran);
+    if (cur->status == THREAD_READY) {
+        cur->involuntary++;
+        sched_stats.sys_involuntary++;
+        cur->ready_tsc = now;
+        cur->woken = false;
+    } else {
+        cur->voluntary++;
+        sched_stats.sys_voluntary++;
+    }
+}
+
+/* Accounts for thread CUR having just been switched in.
+   Interrupts must be off. */
+static void
+sched_switch_in(struct thread *cur) {
+    cur->run_tsc = rdtsc();
+    if (cur != cpu_current()->idle_thread)
+        sched_hist_add(cur->woken ? SCHEDSTAT_WAKEUP : SCHEDSTAT_REQUEUE,
+                       cur->run_tsc - cur->ready_tsc);
+}
+
+/* Adds an interval of CYCLES to histogram H.  Interrupts must be
+   off. */
+static void
+sched_hist_add(enum schedstat_hist h, uint64_t cycles) {
+    uint32_t high = cycles >> 32;
+    int bucket;
+
+    /* Written out because i386 has no 64-bit count-leading-zeros. */
+    if (high != 0)
+        bucket = SCHEDSTAT_BUCKETS - 1;
+    else if ((uint32_t) cycles == 0)
+        bucket = 0;
+    else
+        bucket = 31 - __builtin_clz((uint32_t) cycles);
+    if (bucket >= SCHEDSTAT_BUCKETS)
+        bucket = SCHEDSTAT_BUCKETS - 1;
+    sched_stats.hist[h][bucket]++;
+}
+
+/* Prints histogram H, labeled WHAT, leaving out the empty buckets
+   at either end. */
+static void
+sched_hist_print(enum schedstat_hist h, const char *what) {
+    const uint32_t *hist = sched_stats.hist[h];
+    int first, last, b;
+
+    for (first = 0; first < SCHEDSTAT_BUCKETS && hist[first] == 0; first++)
+        continue;
+    for (last = SCHEDSTAT_BUCKETS - 1; last > first && hist[last] == 0; last--)
+        continue;
+
+    printf("Thread: %s, TSC cycles:\n", what);
+    for (b = first; b <= last; b++)
+        printf("Thread: %12llu .. %12llu: %8"PRIu32"\n",
+               b == 0 ? 0ULL : 1ULL << b, (2ULL << b) - 1, hist[b]);
+}
+
+/* Does the 4.4BSD scheduler's per-tick bookkeeping.
+   Runs in the timer interrupt. */
+static void
+mlfqs_tick(void) {
+    struct thread *cur = thread_current();
+    int64_t ticks = timer_ticks();
+    uint64_t start = rdtsc();
+    uint64_t cycles;
+
+    if (cur != cpu_current()->idle_thread)
+        cur->recent_cpu = FP_ADD_MIX(cur->recent_cpu, 1);
+
+    if (ticks % TIMER_FREQ == 0) {
+        unsigned updated = mlfqs_second();
+        cycles = rdtsc() - start;
+        if (cycles > mlfqs_sec_max) {
+            mlfqs_sec_max = cycles;
+            mlfqs_sec_max_threads = updated;
+        }
+    } else if (ticks % 4 == 0 && cur != cpu_current()->idle_thread) {
+        /* Only the running thread's recent_cpu has changed. */
+        mlfqs_update(cur);
+    }
+    if (ready_preempts(cur))
+        intr_yield_on_return();
+
+    cycles = rdtsc() - start;
+    mlfqs_tick_cycles += cycles;
+    if (cycles > mlfqs_tick_max)
+        mlfqs_tick_max = cycles;
+}
+
+/* Does the 4.4BSD scheduler's once-a-second update of the load
+   average and of the recent_cpu and priority of the running and
+   ready threads.  Returns the number of threads updated. */
+static unsigned
+mlfqs_second(void) {
+    struct thread *cur = thread_current();
+    int ready_threads = ready_cnt + (cur != cpu_current()->idle_thread);
+    unsigned updated = 0;
+    fixed_t twice_load;
+    int pri;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    /* load_avg = (59/60)*load_avg + (1/60)*ready_threads. */
+    load_avg = FP_ADD(FP_DIV_MIX(FP_MULT_MIX(load_avg, 59), 60),
+                      FP_DIV_MIX(FP_CONST(ready_threads), 60));
+
+    /* recent_cpu decays by (2*load_avg)/(2*load_avg + 1). */
+    twice_load = FP_MULT_MIX(load_avg, 2);
+    decay_history[mlfqs_sec % DECAY_HISTORY] =
+        FP_DIV(twice_load, FP_ADD_MIX(twice_load, 1));
+    mlfqs_sec++;
+
+    if (cur != cpu_current()->idle_thread) {
+        mlfqs_update(cur);
+        updated++;
+    }
+
+    /* A thread whose priority changes moves to a queue that may
+       be visited again later; updating it again is harmless. */
+    for (pri = PRI_MIN; pri <= PRI_MAX; pri++) {
+        struct list *queue = &ready_queues[pri];
+        struct list_elem *e = list_begin(queue);
+
+        while (e != list_end(queue)) {
+            struct thread *t = list_entry(e, struct thread, elem);
+            e = list_next(e);
+            mlfqs_update(t);
+            updated++;
+        }
+    }
+    return updated;
+}
+
+/* Brings T's recent_cpu up to date with the once-a-second decay
+   and recomputes its priority from it and T's nice value.
+   Interrupts must be off. */
+static void
+mlfqs_update(struct thread *t) {
+    fixed_t recent_cpu = t->recent_cpu;
+    int64_t sec = t->recent_cpu_sec;
+    int priority;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t != cpu_current()->idle_thread);
+
+    if (mlfqs_sec - sec > DECAY_HISTORY) {
+        /* recent_cpu = nice / (1 - decay) is the fixed point of
+           recent_cpu = decay * recent_cpu + nice. */
+        fixed_t decay = decay_history[mlfqs_sec % DECAY_HISTORY];
+        recent_cpu = FP_DIV(FP_CONST(t->nice), FP_SUB(FP_CONST(1), decay));
+        sec = mlfqs_sec - DECAY_HISTORY;
+    }
+    for (; sec < mlfqs_sec; sec++)
+        recent_cpu = FP_ADD_MIX(FP_MULT(decay_history[sec % DECAY_HISTORY],
+                                        recent_cpu), t->nice);
+    t->recent_cpu = recent_cpu;
+    t->recent_cpu_sec = mlfqs_sec;
+
+    /* priority = PRI_MAX - (recent_cpu / 4) - (nice * 2). */
+    priority = FP_INT_PART(FP_SUB(FP_CONST(PRI_MAX - t->nice * 2),
+                                  FP_DIV_MIX(recent_cpu, 4)));
+    if (priority < PRI_MIN)
+        priority = PRI_MIN;
+    else if (priority > PRI_MAX)
+        priority = PRI_MAX;
+    t->base_priority = priority;
+    thread_update_priority(t);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -160,9 +543,8 @@ thread_print_stats(void) {
    thread may run for any amount of time before the new thread is
    scheduled.  Use a semaphore or some other form of
    synchronization if you need to ensure ordering.
-   The code provided sets the new thread's `priority' member to
-   PRIORITY, but no actual priority scheduling is implemented.
-   Priority scheduling is the goal of Problem 1-3. */
+   If PRIORITY is higher than the running thread's priority, the
+   new thread preempts it before thread_create() returns. */
 tid_t
 thread_create(const char *name, int priority,
               thread_func *function, void *aux) {
@@ -175,8 +557,21 @@ thread_create(const char *name, int priority,
 
     ASSERT(function != NULL);
 
-    /* Allocate thread. */
-    t = palloc_get_page(PAL_ZERO);
+    if (thread_stride && thread_cnt >= STRIDE_HEAP_MAX)
+        return TID_ERROR;
+
+    /* Allocate thread, from the cache if possible. */
+    spinlock_acquire(&thread_cache_lock);
+    if (thread_cache_cnt > 0) {
+        t = thread_cache[--thread_cache_cnt];
+        thread_cache_hits++;
+    } else {
+        t = NULL;
+        thread_cache_misses++;
+    }
+    spinlock_release(&thread_cache_lock);
+    if (t == NULL)
+        t = palloc_get_page(0);
     if (t == NULL)
         return TID_ERROR;
 
@@ -209,10 +604,12 @@ thread_create(const char *name, int priority,
     sf->eip = switch_entry;
     sf->ebp = 0;
 
+    thread_cnt++;
     intr_set_level(old_level);
 
     /* Add to run queue. */
     thread_unblock(t);
+    thread_preempt();
 
     return tid;
 }
@@ -246,8 +643,20 @@ thread_unblock(struct thread *t) {
 
     old_level = intr_disable();
     ASSERT(t->status == THREAD_BLOCKED);
-    list_push_back(&ready_list, &t->elem);
+    if (t->rt_throttled) {
+        /* Stays off the CPU until its next period. */
+        t->rt_parked = true;
+        intr_set_level(old_level);
+        return;
+    }
+    if (thread_mlfqs && t != cpu_current()->idle_thread)
+        mlfqs_update(t);
+    ready_push(t);
     t->status = THREAD_READY;
+    if (thread_schedstat) {
+        t->ready_tsc = rdtsc();
+        t->woken = true;
+    }
     intr_set_level(old_level);
 }
 
@@ -302,6 +711,8 @@ thread_exit(void) {
     }
 
     intr_disable();
+    if (thread_current()->rt_period > 0)
+        rt_leave(thread_current());
     list_remove(&thread_current()->allelem);
     thread_current()->status = THREAD_DYING;
     schedule();
@@ -318,13 +729,40 @@ thread_yield(void) {
     ASSERT(!intr_context());
 
     old_level = intr_disable();
-    if (cur != idle_thread)
-        list_push_back(&ready_list, &cur->elem);
+    if (cur->rt_throttled) {
+        /* Out of budget: sit out the rest of the period. */
+        cur->rt_parked = true;
+        cur->status = THREAD_BLOCKED;
+        schedule();
+        intr_set_level(old_level);
+        return;
+    }
+    if (cur != cpu_current()->idle_thread)
+        ready_push(cur);
     cur->status = THREAD_READY;
     schedule();
     intr_set_level(old_level);
 }
 
+/* Yields the CPU if a thread of higher priority than the running
+   thread is ready to run.  In an external interrupt handler, the
+   yield happens just before the interrupt returns.
+   Call this after making a thread ready, since thread_unblock()
+   itself never preempts. */
+void
+thread_preempt(void) {
+    enum intr_level old_level = intr_disable();
+    bool preempt = ready_preempts(thread_current());
+    intr_set_level(old_level);
+
+    if (!preempt)
+        return;
+    if (intr_context())
+        intr_yield_on_return();
+    else
+        thread_yield();
+}
+
 /* Invoke function 'func' on all threads, passing along 'aux'.
    This function must be called with interrupts off. */
 void
@@ -341,43 +779,290 @@ thread_foreach(thread_action_func *func, void *aux) {
     }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's base priority to NEW_PRIORITY.
+   Priority donated to it through locks it holds still applies.
+   Ignored under the 4.4BSD scheduler, which sets priorities
+   itself. */
 void
 thread_set_priority(int new_priority) {
-    thread_current()->priority = new_priority;
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+    if (thread_mlfqs)
+        return;
+
+    old_level = intr_disable();
+    cur->base_priority = new_priority;
+    thread_update_priority(cur);
+    intr_set_level(old_level);
+
+    thread_preempt();
+}
+
+/* Recomputes T's effective priority: its base priority, raised
+   to the highest priority donated through any lock T holds.
+   A ready T is moved to the run queue for its new priority.
+   Does not preempt; see thread_preempt().  Interrupts must be
+   off. */
+void
+thread_update_priority(struct thread *t) {
+    int priority = t->base_priority;
+    struct list_elem *e;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(is_thread(t));
+
+    if (!thread_mlfqs)
+        for (e = list_begin(&t->locks); e != list_end(&t->locks);
+             e = list_next(e)) {
+            struct lock *l = list_entry(e, struct lock, elem);
+            if (l->max_priority > priority)
+                priority = l->max_priority;
+        }
+
+    if (priority == t->priority)
+        return;
+    if (t->status == THREAD_READY && !thread_stride && !rt_active(t)) {
+        ready_remove(t);
+        t->priority = priority;
+        ready_push(t);
+    } else
+        t->priority = priority;
 }
 
-/* Returns the current thread's priority. */
+/* Returns the current thread's effective priority. */
 int
 thread_get_priority(void) {
     return thread_current()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE, clamped to
+   NICE_MIN...NICE_MAX, and yields if it no longer has the
+   highest priority. */
 void
-thread_set_nice(int nice UNUSED) {
-    /* Not yet implemented. */
+thread_set_nice(int nice) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    else if (nice > NICE_MAX)
+        nice = NICE_MAX;
+
+    old_level = intr_disable();
+    cur->nice = nice;
+    if (thread_mlfqs && cur != cpu_current()->idle_thread)
+        mlfqs_update(cur);
+    intr_set_level(old_level);
+
+    thread_preempt();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice(void) {
-    /* Not yet implemented. */
-    return 0;
+    return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg(void) {
-    /* Not yet implemented. */
-    return 0;
+    enum intr_level old_level = intr_disable();
+    int load = FP_ROUND(FP_MULT_MIX(load_avg, 100));
+    intr_set_level(old_level);
+
+    return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu(void) {
-    /* Not yet implemented. */
-    return 0;
+    enum intr_level old_level = intr_disable();
+    int recent = FP_ROUND(FP_MULT_MIX(thread_current()->recent_cpu, 100));
+    intr_set_level(old_level);
+
+    return recent;
+}
+
+/* Sets the current thread's stride-scheduler share to TICKETS.
+   Returns false, changing nothing, if TICKETS is outside
+   TICKETS_MIN...TICKETS_MAX. */
+bool
+thread_set_tickets(int tickets) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    if (tickets < TICKETS_MIN || tickets > TICKETS_MAX)
+        return false;
+
+    old_level = intr_disable();
+    cur->tickets = tickets;
+    cur->stride = STRIDE1 / tickets;
+    intr_set_level(old_level);
+    return true;
+}
+
+/* Returns the current thread's stride-scheduler share. */
+int
+thread_get_tickets(void) {
+    return thread_current()->tickets;
+}
+
+/* Makes the current thread periodic, with a new job released
+   every PERIOD timer ticks, each of which is guaranteed BUDGET
+   ticks of CPU time by the end of its period.  The first period
+   starts now.  Returns false, changing nothing, if BUDGET is not
+   between 1 and PERIOD or if admission control rejects the
+   reservation.  A PERIOD of 0 returns the thread to the normal
+   class. */
+bool
+thread_set_periodic(int64_t period, int64_t budget) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+    int util;
+
+    if (period == 0) {
+        old_level = intr_disable();
+        if (cur->rt_period > 0)
+            rt_leave(cur);
+        intr_set_level(old_level);
+        thread_preempt();
+        return true;
+    }
+    if (period < 0 || budget < 1 || budget > period)
+        return false;
+    util = DIV_ROUND_UP(budget * RT_UTIL_SCALE, period);
+
+    old_level = intr_disable();
+    if (rt_util_total - cur->rt_util + util > RT_UTIL_MAX) {
+        intr_set_level(old_level);
+        return false;
+    }
+    if (cur->rt_period == 0) {
+        list_push_back(&rt_threads, &cur->rt_elem);
+        rt_admitted++;
+    }
+    rt_util_total += util - cur->rt_util;
+    cur->rt_util = util;
+    cur->rt_period = period;
+    cur->rt_budget = budget;
+    cur->rt_deadline = timer_ticks() + period;
+    cur->rt_used = 0;
+    cur->rt_done = cur->rt_pending = cur->rt_throttled = false;
+    if (cur->rt_deadline < rt_next_release)
+        rt_next_release = cur->rt_deadline;
+    intr_set_level(old_level);
+    return true;
+}
+
+/* Marks the current periodic thread's job for this period done
+   and sleeps until the next period begins.  Returns at once if
+   the job overran and the next period has already begun. */
+void
+thread_wait_period(void) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(cur->rt_period > 0);
+
+    old_level = intr_disable();
+    if (cur->rt_pending)
+        cur->rt_pending = false;
+    else {
+        cur->rt_done = true;
+        cur->rt_parked = true;
+        thread_block();
+    }
+    intr_set_level(old_level);
+}
+
+/* Returns the timer tick at which the next real-time period
+   begins, or INT64_MAX if there are no real-time threads. */
+int64_t
+thread_next_release(void) {
+    return rt_next_release;
+}
+
+/* Returns the number of deadlines the current thread has
+   missed. */
+unsigned
+thread_get_deadline_misses(void) {
+    return thread_current()->rt_misses;
+}
+
+/* Returns true if T should be scheduled in the real-time class:
+   it is periodic and has budget left in this period. */
+static bool
+rt_active(const struct thread *t) {
+    return t->rt_period > 0 && !t->rt_throttled;
+}
+
+/* Orders threads by real-time deadline. */
+static bool
+deadline_less(const struct list_elem *a_, const struct list_elem *b_,
+              void *aux UNUSED) {
+    const struct thread *a = list_entry(a_, struct thread, elem);
+    const struct thread *b = list_entry(b_, struct thread, elem);
+
+    return a->rt_deadline < b->rt_deadline;
+}
+
+/* Starts a new period for every real-time thread whose deadline
+   is at or before NOW.  Runs in the timer interrupt. */
+static void
+rt_release(int64_t now) {
+    struct list_elem *e;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    rt_next_release = INT64_MAX;
+    for (e = list_begin(&rt_threads); e != list_end(&rt_threads);
+         e = list_next(e)) {
+        struct thread *t = list_entry(e, struct thread, rt_elem);
+
+        if (t->rt_deadline <= now) {
+            if (!t->rt_done) {
+                t->rt_misses++;
+                rt_misses++;
+                t->rt_pending = true;
+            }
+            while (t->rt_deadline <= now)
+                t->rt_deadline += t->rt_period;
+            t->rt_used = 0;
+            t->rt_done = t->rt_throttled = false;
+
+            if (t->rt_parked) {
+                t->rt_parked = false;
+                thread_unblock(t);
+            } else if (t->status == THREAD_READY) {
+                /* Re-sort by its new deadline. */
+                list_remove(&t->elem);
+                list_insert_ordered(&rt_ready_list, &t->elem,
+                                    deadline_less, NULL);
+            }
+        }
+        if (t->rt_deadline < rt_next_release)
+            rt_next_release = t->rt_deadline;
+    }
+
+    if (ready_preempts(thread_current()))
+        intr_yield_on_return();
+}
+
+/* Returns T, which must be the running thread, to the normal
+   class.  Interrupts must be off. */
+static void
+rt_leave(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t == thread_current());
+
+    list_remove(&t->rt_elem);
+    rt_util_total -= t->rt_util;
+    t->rt_util = 0;
+    t->rt_period = 0;
+    t->rt_done = t->rt_pending = t->rt_throttled = false;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -391,7 +1076,7 @@ thread_get_recent_cpu(void) {
 static void
 idle(void *idle_started_ UNUSED) {
     struct semaphore *idle_started = idle_started_;
-    idle_thread = thread_current();
+    cpu_current()->idle_thread = thread_current();
     sema_up(idle_started);
 
     for (;;) {
@@ -399,6 +1084,9 @@ idle(void *idle_started_ UNUSED) {
         intr_disable();
         thread_block();
 
+        /* Stop the periodic timer if nothing is due soon. */
+        timer_idle_enter();
+
         /* Re-enable interrupts and wait for the next one.
            The `sti' instruction disables interrupts until the
            completion of the next instruction, so these two
@@ -408,7 +1096,10 @@ idle(void *idle_started_ UNUSED) {
            one to occur, wasting as much as one clock tick worth of
            time.
            See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-           7.11.1 "HLT Instruction". */
+           7.11.1 "HLT Instruction".
+           The interrupts-off window ends at the `sti', not when
+           the next interrupt arrives, so say so to the tracer. */
+        intr_trace_sti();
         asm volatile ("sti; hlt" : : : "memory");
     }
 }
@@ -455,7 +1146,23 @@ init_thread(struct thread *t, const char *name, int priority) {
    // t->tid = tid;
     strlcpy(t->name, name, sizeof t->name);
     t->stack = (uint8_t *) t + PGSIZE;
-    t->priority = priority;
+    t->priority = t->base_priority = priority;
+    list_init(&t->locks);
+    t->wait_lock = NULL;
+    t->nice = NICE_DEFAULT;
+    t->recent_cpu = 0;
+    t->recent_cpu_sec = mlfqs_sec;
+    t->tickets = TICKETS_DEFAULT;
+    if (t != running_thread() && is_thread(running_thread())) {
+        /* Inherit the creator's scheduler state. */
+        struct thread *parent = running_thread();
+        t->nice = parent->nice;
+        t->recent_cpu = parent->recent_cpu;
+        t->tickets = parent->tickets;
+    }
+    t->stride = STRIDE1 / t->tickets;
+    t->pass = global_pass;
+    t->run_tsc = rdtsc();
     t->magic = THREAD_MAGIC;
     t->exit_code = -1;
     t->wait_status = NULL;
@@ -464,6 +1171,11 @@ init_thread(struct thread *t, const char *name, int priority) {
     t->pagedir = NULL;
     t->pages = NULL;
     t->bin_file = NULL;
+#ifdef USERPROG
+    t->proc = t;
+    lock_init(&t->proc_lock);
+    list_init(&t->uthreads);
+#endif
     list_init (&t->fds);
     list_init (&t->mappings);
     t->next_handle = 2;
@@ -487,21 +1199,173 @@ alloc_frame(struct thread *t, size_t size) {
     ASSERT(size % sizeof(uint32_t) == 0);
 
     t->stack -= size;
+    memset(t->stack, 0, size);
     return t->stack;
 }
 
+/* Adds T to the back of the run queue for its priority.
+   Interrupts must be off. */
+static void
+ready_push(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+    ready_cnt++;
+    if (rt_active(t)) {
+        list_insert_ordered(&rt_ready_list, &t->elem, deadline_less, NULL);
+        return;
+    }
+    if (thread_stride) {
+        stride_push(t);
+        return;
+    }
+
+    list_push_back(&ready_queues[t->priority], &t->elem);
+    ready_mask[t->priority / 32] |= 1u << (t->priority % 32);
+}
+
+/* Removes ready thread T from its run queue.
+   Interrupts must be off. */
+static void
+ready_remove(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->status == THREAD_READY);
+
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[t->priority]))
+        ready_mask[t->priority / 32] &= ~(1u << (t->priority % 32));
+    ready_cnt--;
+}
+
+/* Adds T to the stride scheduler's heap.  A thread that has been
+   blocked is not credited for the time it slept: its pass is
+   brought forward to the current virtual time.
+   Interrupts must be off. */
+static void
+stride_push(struct thread *t) {
+    size_t i = stride_cnt++;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(i < STRIDE_HEAP_MAX);
+
+    if (t->pass < global_pass)
+        t->pass = global_pass;
+
+    /* Sift up. */
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (stride_heap[parent]->pass <= t->pass)
+            break;
+        stride_heap[i] = stride_heap[parent];
+        i = parent;
+    }
+    stride_heap[i] = t;
+}
+
+/* Removes and returns the thread with the lowest pass from the
+   stride scheduler's heap, which must not be empty.
+   Interrupts must be off. */
+static struct thread *
+stride_pop(void) {
+    struct thread *min = stride_heap[0];
+    struct thread *last;
+    size_t cnt, i;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(stride_cnt > 0);
+
+    cnt = --stride_cnt;
+    last = stride_heap[cnt];
+
+    /* Sift the last element down from the root. */
+    i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= cnt)
+            break;
+        if (child + 1 < cnt
+            && stride_heap[child + 1]->pass < stride_heap[child]->pass)
+            child++;
+        if (last->pass <= stride_heap[child]->pass)
+            break;
+        stride_heap[i] = stride_heap[child];
+        i = child;
+    }
+    if (cnt > 0)
+        stride_heap[i] = last;
+
+    global_pass = min->pass;
+    return min;
+}
+
+/* Returns true if a ready thread should run in preference to
+   CUR, the running thread.  Interrupts must be off. */
+static bool
+ready_preempts(struct thread *cur) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (cur == cpu_current()->idle_thread)
+        return false;
+    if (!list_empty(&rt_ready_list)) {
+        struct thread *t = list_entry(list_front(&rt_ready_list),
+                                      struct thread, elem);
+        return !rt_active(cur) || t->rt_deadline < cur->rt_deadline;
+    }
+    if (rt_active(cur))
+        return false;
+    if (thread_stride)
+        return stride_cnt > 0 && stride_heap[0]->pass < cur->pass;
+    return ready_max_priority() > cur->priority;
+}
+
+/* Returns the priority of the highest-priority ready thread, or
+   -1 if no thread is ready.  Interrupts must be off. */
+static int
+ready_max_priority(void) {
+    int word;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    for (word = sizeof ready_mask / sizeof *ready_mask - 1; word >= 0; word--)
+        if (ready_mask[word] != 0)
+            return word * 32 + 31 - __builtin_clz(ready_mask[word]);
+    return -1;
+}
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   idle_thread.
+   Picks the front of the highest-priority nonempty queue, so
+   threads of equal priority run round-robin. */
 static struct thread *
 next_thread_to_run(void) {
-    if (list_empty(&ready_list))
-        return idle_thread;
-    else
-        return list_entry(list_pop_front(&ready_list),
-    struct thread, elem);
+    int priority;
+    struct list *queue;
+    struct thread *t;
+
+    if (!list_empty(&rt_ready_list)) {
+        ready_cnt--;
+        return list_entry(list_pop_front(&rt_ready_list), struct thread, elem);
+    }
+    if (thread_stride) {
+        if (stride_cnt == 0)
+            return cpu_current()->idle_thread;
+        ready_cnt--;
+        return stride_pop();
+    }
+
+    priority = ready_max_priority();
+    if (priority < 0)
+        return cpu_current()->idle_thread;
+
+    queue = &ready_queues[priority];
+    t = list_entry(list_pop_front(queue), struct thread, elem);
+    if (list_empty(queue))
+        ready_mask[priority / 32] &= ~(1u << (priority % 32));
+    ready_cnt--;
+    return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -527,7 +1391,9 @@ thread_schedule_tail(struct thread *prev) {
     cur->status = THREAD_RUNNING;
 
     /* Start new time slice. */
-    thread_ticks = 0;
+    cpu_current()->thread_ticks = 0;
+    if (thread_schedstat && prev != NULL)
+        sched_switch_in(cur);
 
 #ifdef USERPROG
     /* Activate the new address space. */
@@ -540,8 +1406,17 @@ thread_schedule_tail(struct thread *prev) {
        initial_thread because its memory was not obtained via
        palloc().) */
     if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) {
+        thread_cnt--;
         ASSERT(prev != cur);
-        palloc_free_page(prev);
+        prev->magic = 0;
+        spinlock_acquire(&thread_cache_lock);
+        if (thread_cache_cnt < THREAD_CACHE_MAX) {
+            thread_cache[thread_cache_cnt++] = prev;
+            prev = NULL;
+        }
+        spinlock_release(&thread_cache_lock);
+        if (prev != NULL)
+            palloc_free_page(prev);
     }
 }
 
@@ -561,8 +1436,12 @@ schedule(void) {
     ASSERT(cur->status != THREAD_RUNNING);
     ASSERT(is_thread(next));
 
-    if (cur != next)
+    if (cur != next) {
+        if (thread_schedstat)
+            sched_switch_out(cur);
+        trace_point(TRACE_SWITCH, cur->tid, next->tid, cur->status);
         prev = switch_threads(cur, next);
+    }
     thread_schedule_tail(prev);
 }
 
@@ -580,9 +1459,9 @@ allocate_tid(void) {
     static tid_t next_tid = 1;
     tid_t tid;
 
-    lock_acquire(&tid_lock);
+    spinlock_acquire(&tid_lock);
     tid = next_tid++;
-    lock_release(&tid_lock);
+    spinlock_release(&tid_lock);
 
     return tid;
 }
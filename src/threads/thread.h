@@ -4,7 +4,9 @@
 #include <debug.h>
 #include <hash.h>
 #include <list.h>
+#include <schedstat.h>
 #include <stdint.h>
+#include <vmstat.h>
 #include <kernel/list.h>
 #include <threads/synch.h>
 
@@ -26,6 +28,23 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the 4.4BSD scheduler. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* Stride-scheduler tickets. */
+#define TICKETS_MIN 1                   /* Smallest share. */
+#define TICKETS_DEFAULT 100             /* Default share. */
+#define TICKETS_MAX 10000               /* Largest share. */
+
+/* Real-time CPU reservations, in thousandths of the CPU. */
+#define RT_UTIL_SCALE 1000              /* The whole CPU. */
+#define RT_UTIL_MAX 900                 /* Most that may be reserved. */
+
+/* Slots in struct thread's cache of recent page lookups. */
+#define PAGE_LOOKUP_CNT 4
+
 /* A kernel thread or user process.
    Each thread structure is stored in its own 4 kB page.  The
    thread structure itself sits at the very bottom of the page
@@ -82,9 +101,45 @@ struct thread {
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
     struct list_elem allelem;           /* List element for all threads list. */
 
+    /* Priority donation, shared between thread.c and synch.c. */
+    int base_priority;                  /* Priority before donations. */
+    struct list locks;                  /* Locks held by this thread. */
+    struct lock *wait_lock;             /* Lock being waited for, or null. */
+
+    /* 4.4BSD scheduler, owned by thread.c. */
+    int nice;                           /* Niceness. */
+    int recent_cpu;                     /* Recent CPU use, in fixed point. */
+    int64_t recent_cpu_sec;             /* Second recent_cpu is current as of. */
+
+    /* Stride scheduler, owned by thread.c. */
+    int tickets;                        /* Share of the CPU. */
+    int64_t stride;                     /* Pass increment per tick. */
+    int64_t pass;                       /* Virtual time; lowest runs next. */
+
+    /* Earliest-deadline-first class, owned by thread.c. */
+    int64_t rt_period;                  /* Period in ticks, 0 if not real-time. */
+    int64_t rt_budget;                  /* CPU ticks allowed per period. */
+    int64_t rt_deadline;                /* End of the current period. */
+    int64_t rt_used;                    /* CPU ticks used this period. */
+    int rt_util;                        /* Reserved share, in RT_UTIL_SCALE. */
+    bool rt_done;                       /* Finished this period's job? */
+    bool rt_pending;                    /* Next job released before done? */
+    bool rt_throttled;                  /* Budget exhausted this period? */
+    bool rt_parked;                     /* Blocked until the next period? */
+    unsigned rt_misses;                 /* Deadlines missed. */
+    struct list_elem rt_elem;           /* Element in real-time thread list. */
+
+    /* Scheduler latency tracing, owned by thread.c. */
+    uint64_t ready_tsc;                 /* TSC when last made ready. */
+    uint64_t run_tsc;                   /* TSC when last switched in. */
+    bool woken;                         /* Made ready by thread_unblock()? */
+    uint64_t voluntary;                 /* Switches away while blocking. */
+    uint64_t involuntary;               /* Switches away while runnable. */
+    uint64_t cpu_cycles;                /* TSC cycles on the CPU. */
+
     /* Owned by process.c. */
     int exit_code;                      /* Exit code. */
     struct wait_status *wait_status;    /* This process's completion status. */
@@ -93,7 +148,8 @@ struct thread {
     /* Shared between thread.c and synch.c. */
     /* Alarm clock. */
     int64_t wakeup_time;                /* Time to wake this thread up. */
-    struct list_elem timer_elem;        /* Element in timer_wait_list. */
+    uint64_t wakeup_tsc;                /* Same, for sub-tick sleeps. */
+    struct list_elem timer_elem;        /* Timing wheel or sub-tick list. */
     struct semaphore timer_sema;        /* Semaphore. */
     struct list_elem elem;              /* List element. */
 
@@ -118,7 +174,21 @@ struct thread {
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
     struct hash *pages;                 /* Page table. */
+    struct page *page_lookup[PAGE_LOOKUP_CNT]; /* Recent `pages' lookups. */
     struct file *bin_file;              /* The binary executable. */
+    struct vmstat vmstat;               /* Virtual memory statistics. */
+
+    /* User threads, owned by userprog/process.c.  Every thread of a
+       process shares `pagedir', `pages' and the file and mapping
+       lists of the process's first thread, `proc'. */
+    struct thread *proc;                /* First thread of our process. */
+    struct uthread *uthread;            /* Join record, null in `proc'. */
+    int ustack_slot;                    /* User stack slot, 0 in `proc'. */
+    struct lock proc_lock;              /* Protects the members below,
+                                           and `pages' once shared. */
+    struct list uthreads;               /* Join records of live threads. */
+    unsigned ustack_slots;              /* Bitmap of stack slots in use. */
+    bool exiting;                       /* Set when the process must die. */
 #endif
     /* Owned by syscall.c. */
     struct list fds;                    /* List of file descriptors. */
@@ -142,6 +212,14 @@ struct child {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the stride (proportional-share) scheduler.
+   Controlled by kernel command-line option "-stride". */
+extern bool thread_stride;
+
+/* If true, trace scheduler latencies.
+   Controlled by kernel command-line option "-schedstat". */
+extern bool thread_schedstat;
+
 void thread_init(void);
 
 void thread_start(void);
@@ -170,6 +248,10 @@ NO_RETURN;
 
 void thread_yield(void);
 
+void thread_preempt(void);
+
+void thread_update_priority(struct thread *);
+
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func(struct thread *t, void *aux);
 
@@ -187,6 +269,20 @@ int thread_get_recent_cpu(void);
 
 int thread_get_load_avg(void);
 
+bool thread_set_tickets(int);
+
+int thread_get_tickets(void);
+
+bool thread_set_periodic(int64_t period, int64_t budget);
+
+void thread_wait_period(void);
+
+unsigned thread_get_deadline_misses(void);
+
+int64_t thread_next_release(void);
+
+bool thread_get_schedstat(struct schedstat *);
+
 bool cmp_waketick(struct list_elem *first, struct list_elem *second, void *aux);
 
 #endif /* threads/thread.h */
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include <ustar.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#include "filesys/fsutil.h"
+#endif
+
+/* Binary event tracing.
+
+   Printing to the console from a hot path changes its timing
+   beyond recognition.  With "-trace", tracepoints in the
+   scheduler, page fault, swap, block I/O, and system call paths
+   instead append a fixed-size record, stamped with the time
+   stamp counter, to a ring buffer allocated at boot.  Recording
+   costs a few dozen instructions with interrupts off and never
+   blocks or allocates, so tracepoints may be placed anywhere,
+   including interrupt handlers and schedule().  When the ring
+   fills up, the oldest records are overwritten.
+
+   At shutdown, trace_dump() writes the records, oldest first,
+   to the scratch block device as a ustar archive holding one file
+   named TRACE_FILE_NAME, which "pintos --get" can copy out.
+   utils/trace-decode turns the file into a timeline. */
+bool trace_enabled;
+
+#define TRACE_PAGES 32          /* Size of the ring buffer. */
+#define TRACE_FILE_NAME "trace.dat"
+
+/* A trace record.  The layout is part of the dump format. */
+struct trace_record
+  {
+    uint64_t tsc;               /* Time stamp counter. */
+    uint16_t event;             /* A TRACE_* event. */
+    uint8_t cpu;                /* CPU that recorded it. */
+    uint8_t intr;               /* 1 if in an interrupt handler. */
+    int32_t tid;                /* Running thread. */
+    uint32_t arg[3];            /* Event-specific arguments. */
+    uint32_t site;              /* Address of the tracepoint. */
+  };
+
+/* Header at the start of a dump.  Also part of the format. */
+struct trace_header
+  {
+    char magic[8];              /* TRACE_MAGIC, not null-terminated. */
+    uint32_t version;           /* TRACE_VERSION. */
+    uint32_t record_size;       /* sizeof (struct trace_record). */
+    uint32_t record_cnt;        /* Number of records that follow. */
+    uint32_t lost_cnt;          /* Number of records overwritten. */
+    uint64_t tsc_per_sec;       /* TSC frequency, 0 if unknown. */
+  };
+
+#define TRACE_MAGIC "PINTRACE"
+#define TRACE_VERSION 1
+
+/* The ring buffer. */
+static struct trace_record *records;
+static size_t record_max;       /* Capacity of `records'. */
+static size_t next;             /* Next slot to fill. */
+static unsigned long long record_cnt;   /* Records ever made. */
+
+#ifdef FILESYS
+static void dump_to_scratch (struct block *);
+#endif
+
+/* Allocates the ring buffer, if tracing. */
+void
+trace_init (void)
+{
+  if (!trace_enabled)
+    return;
+
+  records = palloc_get_multiple (0, TRACE_PAGES);
+  if (records == NULL)
+    {
+      printf ("trace: no memory for trace buffer, tracing disabled\n");
+      trace_enabled = false;
+      return;
+    }
+  record_max = TRACE_PAGES * PGSIZE / sizeof *records;
+}
+
+/* Appends a record of EVENT with arguments A, B, and C to the
+   trace buffer.  Use trace_point() rather than calling this
+   directly. */
+void
+trace_record (enum trace_event event, uint32_t a, uint32_t b, uint32_t c)
+{
+  struct trace_record *r;
+  enum intr_level old_level;
+
+  if (records == NULL)
+    return;
+
+  old_level = intr_disable ();
+  r = &records[next];
+  if (++next >= record_max)
+    next = 0;
+  record_cnt++;
+
+  r->tsc = rdtsc ();
+  r->event = event;
+  r->cpu = cpu_current ()->id;
+  r->intr = intr_context ();
+  r->tid = thread_current ()->tid;
+  r->arg[0] = a;
+  r->arg[1] = b;
+  r->arg[2] = c;
+  r->site = (uintptr_t) __builtin_return_address (0);
+  intr_set_level (old_level);
+}
+
+/* Stops tracing and writes the trace buffer to the scratch
+   device, if there is one. */
+void
+trace_dump (void)
+{
+  size_t kept;
+
+  if (!trace_enabled)
+    return;
+  trace_enabled = false;
+
+  kept = record_cnt < record_max ? record_cnt : record_max;
+  printf ("Trace: %llu records, %zu kept\n", record_cnt, kept);
+#ifdef FILESYS
+  /* Writing to a block device sleeps, which is impossible when
+     shutting down from an interrupt handler or a panic. */
+  if (intr_context () || intr_get_level () == INTR_OFF)
+    {
+      printf ("Trace: interrupts off, trace discarded\n");
+      return;
+    }
+  if (block_get_role (BLOCK_SCRATCH) != NULL)
+    {
+      dump_to_scratch (block_get_role (BLOCK_SCRATCH));
+      return;
+    }
+#endif
+  printf ("Trace: no scratch device, trace discarded\n");
+}
+
+#ifdef FILESYS
+/* Sector buffer and position for dump_bytes(). */
+static uint8_t *dump_buffer;
+static size_t dump_ofs;
+static block_sector_t dump_sector;
+
+/* Appends SIZE bytes from DATA to the dump on SCRATCH. */
+static void
+dump_bytes (struct block *scratch, const void *data_, size_t size)
+{
+  const uint8_t *data = data_;
+
+  while (size > 0)
+    {
+      size_t chunk = BLOCK_SECTOR_SIZE - dump_ofs;
+      if (chunk > size)
+        chunk = size;
+      memcpy (dump_buffer + dump_ofs, data, chunk);
+      data += chunk;
+      size -= chunk;
+      dump_ofs += chunk;
+      if (dump_ofs == BLOCK_SECTOR_SIZE)
+        {
+          block_write (scratch, dump_sector++, dump_buffer);
+          dump_ofs = 0;
+        }
+    }
+}
+
+/* Writes the trace as a file in the ustar archive on SCRATCH,
+   after any files that fsutil_append() wrote there ("pintos -g"),
+   dropping the oldest records if it does not fit. */
+static void
+dump_to_scratch (struct block *scratch)
+{
+  struct trace_header h;
+  size_t kept = record_cnt < record_max ? record_cnt : record_max;
+  block_sector_t start = fsutil_append_sector ();
+  size_t room, first, i;
+
+  /* Leave room for the ustar header sector, our own header, and
+     the two end-of-archive sectors. */
+  if (block_size (scratch) < start + 4)
+    {
+      printf ("Trace: scratch device full, trace discarded\n");
+      return;
+    }
+  room = block_size (scratch) - start - 3;
+  room = (room * BLOCK_SECTOR_SIZE - sizeof h) / sizeof *records;
+  if (kept > room)
+    kept = room;
+
+  dump_buffer = malloc (BLOCK_SECTOR_SIZE);
+  if (dump_buffer == NULL)
+    {
+      printf ("Trace: no memory for dump, trace discarded\n");
+      return;
+    }
+  first = (next + record_max - kept) % record_max;
+
+  memcpy (h.magic, TRACE_MAGIC, sizeof h.magic);
+  h.version = TRACE_VERSION;
+  h.record_size = sizeof *records;
+  h.record_cnt = kept;
+  h.lost_cnt = record_cnt - kept;
+  h.tsc_per_sec = timer_tsc_per_tick () * TIMER_FREQ;
+
+  dump_sector = start;
+  dump_ofs = 0;
+  ustar_make_header (TRACE_FILE_NAME, USTAR_REGULAR,
+                     sizeof h + kept * sizeof *records,
+                     (char *) dump_buffer);
+  block_write (scratch, dump_sector++, dump_buffer);
+  dump_bytes (scratch, &h, sizeof h);
+  for (i = 0; i < kept; i++)
+    dump_bytes (scratch, &records[(first + i) % record_max],
+                sizeof *records);
+
+  /* Pad out the last sector, then write the end-of-archive
+     marker, as far as the device has room for it. */
+  if (dump_ofs > 0)
+    {
+      memset (dump_buffer + dump_ofs, 0, BLOCK_SECTOR_SIZE - dump_ofs);
+      block_write (scratch, dump_sector++, dump_buffer);
+    }
+  memset (dump_buffer, 0, BLOCK_SECTOR_SIZE);
+  for (i = 0; i < 2 && dump_sector < block_size (scratch); i++)
+    block_write (scratch, dump_sector++, dump_buffer);
+  free (dump_buffer);
+
+  printf ("Trace: %zu records written to %s as \"%s\"\n",
+          kept, block_name (scratch), TRACE_FILE_NAME);
+}
+#endif /* FILESYS */
@@ -0,0 +1,43 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kinds of trace records.
+   The values are part of the dump format read by
+   utils/trace-decode, so add new events at the end. */
+enum trace_event
+  {
+    TRACE_SWITCH = 1,           /* Context switch: prev, next, prev status. */
+    TRACE_SYSCALL_ENTER,        /* System call: number. */
+    TRACE_SYSCALL_EXIT,         /* System call: number, return value. */
+    TRACE_FAULT_ENTER,          /* Page fault: address, error code, eip. */
+    TRACE_FAULT_EXIT,           /* Page fault: address, handled? */
+    TRACE_SWAP_IN_ENTER,        /* Swap-in: first sector. */
+    TRACE_SWAP_IN_EXIT,         /* Swap-in: first sector. */
+    TRACE_SWAP_OUT_ENTER,       /* Swap-out. */
+    TRACE_SWAP_OUT_EXIT,        /* Swap-out: first sector, or -1. */
+    TRACE_BLOCK_READ_ENTER,     /* Block read: device type, sector. */
+    TRACE_BLOCK_READ_EXIT,      /* Block read: device type, sector. */
+    TRACE_BLOCK_WRITE_ENTER,    /* Block write: device type, sector. */
+    TRACE_BLOCK_WRITE_EXIT      /* Block write: device type, sector. */
+  };
+
+/* If true, record tracepoints in the trace buffer.
+   Controlled by kernel command-line option "-trace". */
+extern bool trace_enabled;
+
+void trace_init (void);
+void trace_record (enum trace_event, uint32_t, uint32_t, uint32_t);
+void trace_dump (void);
+
+/* Records EVENT with arguments A, B, and C, if tracing. */
+static inline void
+trace_point (enum trace_event event, uint32_t a, uint32_t b, uint32_t c)
+{
+  if (trace_enabled)
+    trace_record (event, a, b, c);
+}
+
+#endif /* threads/trace.h */
@@ -0,0 +1,139 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Work queues, for deferring work out of interrupt handlers and
+   latency-sensitive paths.
+
+   A work queue has its own pool of kernel threads, all at the
+   priority given to workqueue_init(), so that urgent and
+   background work can be kept on separate queues.  work_queue()
+   only links the item onto the queue and ups a semaphore, so it
+   may be called from an interrupt handler.
+
+   Queuing an item that is already waiting to run does nothing:
+   the two requests are coalesced into a single run.  An item
+   stops being pending just before its function is called, so a
+   request made while the function runs is not lost but causes
+   one more run.  An item must not be freed or reinitialized while
+   it is pending. */
+
+/* All work queues, for workqueue_print_stats(). */
+static struct list all_queues = LIST_INITIALIZER (all_queues);
+
+static thread_func worker;
+
+/* Initializes WORK to call FUNC, which may use AUX. */
+void
+work_init (struct work *work, work_func *func, void *aux)
+{
+  ASSERT (work != NULL);
+  ASSERT (func != NULL);
+
+  work->func = func;
+  work->aux = aux;
+  work->pending = false;
+}
+
+/* Initializes WQ, naming it NAME for statistics, and starts
+   WORKER_CNT worker threads for it at PRIORITY.  Returns true if
+   successful, false if not even one worker could be started.
+   Work queues are never destroyed. */
+bool
+workqueue_init (struct workqueue *wq, const char *name, int priority,
+                int worker_cnt)
+{
+  enum intr_level old_level;
+  int started = 0;
+  int i;
+
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+  ASSERT (worker_cnt > 0);
+
+  wq->name = name;
+  list_init (&wq->items);
+  sema_init (&wq->avail, 0);
+  wq->queued_cnt = wq->coalesced_cnt = wq->run_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_queues, &wq->elem);
+  intr_set_level (old_level);
+
+  for (i = 0; i < worker_cnt; i++)
+    if (thread_create (name, priority, worker, wq) != TID_ERROR)
+      started++;
+  return started > 0;
+}
+
+/* Queues WORK to be run by one of WQ's workers.  Returns true if
+   WORK was queued, false if it was already pending, in which case
+   this request is coalesced with the earlier one.
+
+   This function may be called from an interrupt handler. */
+bool
+work_queue (struct workqueue *wq, struct work *work)
+{
+  enum intr_level old_level;
+  bool queued;
+
+  ASSERT (wq != NULL);
+  ASSERT (work != NULL);
+
+  old_level = intr_disable ();
+  queued = !work->pending;
+  if (queued)
+    {
+      work->pending = true;
+      list_push_back (&wq->items, &work->elem);
+      wq->queued_cnt++;
+    }
+  else
+    wq->coalesced_cnt++;
+  intr_set_level (old_level);
+
+  if (queued)
+    sema_up (&wq->avail);
+  return queued;
+}
+
+/* Prints statistics for every work queue. */
+void
+workqueue_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_queues); e != list_end (&all_queues);
+       e = list_next (e))
+    {
+      struct workqueue *wq = list_entry (e, struct workqueue, elem);
+      printf ("Workqueue %s: %llu queued, %llu coalesced, %llu run\n",
+              wq->name, wq->queued_cnt, wq->coalesced_cnt, wq->run_cnt);
+    }
+}
+
+/* A work queue's worker thread.  Runs the items queued on WQ_,
+   oldest first, forever. */
+static void
+worker (void *wq_)
+{
+  struct workqueue *wq = wq_;
+
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *work;
+
+      sema_down (&wq->avail);
+
+      old_level = intr_disable ();
+      work = list_entry (list_pop_front (&wq->items), struct work, elem);
+      work->pending = false;
+      wq->run_cnt++;
+      intr_set_level (old_level);
+
+      work->func (work);
+    }
+}
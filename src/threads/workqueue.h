@@ -0,0 +1,44 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* A function run by a work queue's worker thread. */
+struct work;
+typedef void work_func (struct work *);
+
+/* An item of work.  Usually embedded in a larger structure that
+   FUNC finds with list_entry()-style pointer arithmetic, or given
+   its data through AUX. */
+struct work
+  {
+    work_func *func;            /* Function to run. */
+    void *aux;                  /* For FUNC's use. */
+    struct list_elem elem;      /* Element in queue's `items' list. */
+    bool pending;               /* Queued but not yet started? */
+  };
+
+/* A queue of work items and the pool of worker threads that run
+   them.  See workqueue.c for details. */
+struct workqueue
+  {
+    const char *name;           /* Name, for statistics. */
+    struct list items;          /* Pending work items, oldest first. */
+    struct semaphore avail;     /* Number of items in `items'. */
+    struct list_elem elem;      /* Element in list of all queues. */
+
+    /* Statistics. */
+    unsigned long long queued_cnt;      /* Items queued. */
+    unsigned long long coalesced_cnt;   /* Queued while already pending. */
+    unsigned long long run_cnt;         /* Items run. */
+  };
+
+void work_init (struct work *, work_func *, void *aux);
+bool workqueue_init (struct workqueue *, const char *name, int priority,
+                     int worker_cnt);
+bool work_queue (struct workqueue *, struct work *);
+void workqueue_print_stats (void);
+
+#endif /* threads/workqueue.h */
@@ -5,6 +5,7 @@
 #include "userprog/syscall.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "vm/page.h"
 
 /* Number of page faults processed. */
@@ -136,6 +137,8 @@ page_fault(struct intr_frame *f) {
 
     /* Count page faults. */
     page_fault_cnt++;
+    trace_point(TRACE_FAULT_ENTER, (uintptr_t) fault_addr, f->error_code,
+                (uintptr_t) f->eip);
 
     /* Determine cause. */
     not_present = (f->error_code & PF_P) == 0;
@@ -144,10 +147,13 @@ page_fault(struct intr_frame *f) {
 
     /* Allow the pager to try to handle it. */
     if (user && not_present) {
-        if (!page_in(fault_addr))
+        bool handled = page_in(fault_addr);
+        trace_point(TRACE_FAULT_EXIT, (uintptr_t) fault_addr, handled, 0);
+        if (!handled)
             thread_exit();
         return;
     }
+    trace_point(TRACE_FAULT_EXIT, (uintptr_t) fault_addr, false, 0);
 
 
     /* To implement virtual memory, delete the rest of the function
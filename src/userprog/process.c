@@ -7,6 +7,7 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
@@ -20,12 +21,20 @@
 #include "threads/malloc.h"
 #include "vm/page.h"
 #include "vm/frame.h"
+#include "vm/futex.h"
 
 static thread_func start_process
 NO_RETURN;
 
 static bool load(const char *cmdline, void (**eip)(void), void **esp);
 
+static thread_func start_uthread
+NO_RETURN;
+
+static void uthread_exit(struct thread *);
+
+static void stop_uthreads(struct thread *);
+
 extern struct list all_list;
 
 /* Data structure shared between process_execute() in the
@@ -159,11 +168,16 @@ process_exit(void) {
     struct thread *cur = thread_current();
     uint32_t *pd;
 
+    if (cur->proc != cur) {
+        uthread_exit(cur);
+        return;
+    }
 
     if (cur->exit_error == -100)
         exit_proc(-1);
 
     int exit_code = cur->exit_error;
+    stop_uthreads(cur);
     printf("%s: exit(%d)\n", cur->name, exit_code);
 
     acquire_filesys_lock();
@@ -204,6 +218,268 @@ process_activate(void) {
     tss_update();
 }
 
+/* User threads.
+
+   A process starts out with one thread.  process_thread_create()
+   adds more, each a kernel thread that shares the first thread's
+   page directory, supplemental page table, open files and memory
+   mappings, and that has a user stack of its own in one of the
+   stack slots laid out by vm/page.c.  The first thread, `proc' in
+   every thread of the process, owns all of that state and does
+   not give it up until every other thread is gone.
+
+   exit() or a fault in any thread ends the whole process: it sets
+   `exiting' in `proc', and each thread dies the next time it
+   returns to user mode (see process_check_exit()).  Threads
+   sleeping in futex_wait() are woken to notice. */
+
+/* Join record of a user thread other than the first.
+   Owned by the process's first thread, on its `uthreads' list,
+   until the thread is joined or the process exits. */
+struct uthread {
+    tid_t tid;                          /* Thread identifier. */
+    struct semaphore done;              /* Upped when the thread is gone. */
+    struct list_elem elem;              /* Element in `uthreads'. */
+};
+
+/* Data passed from process_thread_create() to start_uthread(). */
+struct uthread_info {
+    struct thread *proc;                /* Process's first thread. */
+    struct uthread *uthread;            /* New thread's join record. */
+    int slot;                           /* New thread's stack slot. */
+    void *eip;                          /* User entry point. */
+    void *func, *aux;                   /* Arguments for the entry point. */
+    struct semaphore started;           /* Upped when started. */
+    bool success;                       /* Started successfully? */
+};
+
+/* Starts a new thread in the running process that begins
+   executing user code at EIP as if called as EIP(FUNC, AUX), with
+   a null return address.  Returns the new thread's tid, or
+   TID_ERROR if the process has no free stack slot or memory is
+   short. */
+tid_t
+process_thread_create(void *eip, void *func, void *aux) {
+    struct thread *proc = thread_current()->proc;
+    struct uthread_info info;
+    struct uthread *ut;
+    tid_t tid;
+
+    ut = malloc(sizeof *ut);
+    if (ut == NULL)
+        return TID_ERROR;
+    sema_init(&ut->done, 0);
+
+    /* Claim a stack slot and make the thread known to the process
+       before it can run, so that exit waits for it. */
+    lock_acquire(&proc->proc_lock);
+    for (info.slot = 1; info.slot < PAGE_STACK_SLOTS; info.slot++)
+        if ((proc->ustack_slots & (1u << info.slot)) == 0)
+            break;
+    if (info.slot >= PAGE_STACK_SLOTS || proc->exiting) {
+        lock_release(&proc->proc_lock);
+        free(ut);
+        return TID_ERROR;
+    }
+    proc->ustack_slots |= 1u << info.slot;
+    list_push_back(&proc->uthreads, &ut->elem);
+    lock_release(&proc->proc_lock);
+
+    info.proc = proc;
+    info.uthread = ut;
+    info.eip = eip;
+    info.func = func;
+    info.aux = aux;
+    sema_init(&info.started, 0);
+    ut->tid = tid = thread_create(proc->name, thread_get_priority(),
+                                  start_uthread, &info);
+    if (tid == TID_ERROR) {
+        lock_acquire(&proc->proc_lock);
+        proc->ustack_slots &= ~(1u << info.slot);
+        list_remove(&ut->elem);
+        lock_release(&proc->proc_lock);
+        free(ut);
+        return TID_ERROR;
+    }
+
+    sema_down(&info.started);
+    if (!info.success) {
+        process_thread_join(tid);
+        return TID_ERROR;
+    }
+    return tid;
+}
+
+/* A thread function that enters user mode in a new thread of an
+   existing process. */
+static void
+start_uthread(void *info_) {
+    struct uthread_info *info = info_;
+    struct thread *cur = thread_current();
+    struct intr_frame if_;
+    uint32_t args[3];
+
+    cur->proc = info->proc;
+    cur->uthread = info->uthread;
+    cur->ustack_slot = info->slot;
+    cur->pagedir = info->proc->pagedir;
+    cur->pages = info->proc->pages;
+    process_activate();
+
+    /* Push the entry point's arguments and return address.  The
+       first page of the stack is allocated here, as stack growth,
+       and the rest on demand. */
+    args[0] = 0;
+    args[1] = (uint32_t) info->func;
+    args[2] = (uint32_t) info->aux;
+    cur->user_esp = (uint8_t *) page_stack_top(info->slot) - sizeof args;
+    info->success = page_lock_range(cur->user_esp, sizeof args, true);
+    if (info->success) {
+        memcpy(cur->user_esp, args, sizeof args);
+        page_unlock_range(cur->user_esp, sizeof args);
+    }
+
+    memset(&if_, 0, sizeof if_);
+    if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.cs = SEL_UCSEG;
+    if_.eflags = FLAG_IF | FLAG_MBS;
+    if_.eip = info->eip;
+    if_.esp = cur->user_esp;
+
+    /* INFO is on our creator's stack and dies once we up this. */
+    if (!info->success) {
+        cur->exit_error = 0;
+        sema_up(&info->started);
+        thread_exit();
+    }
+    sema_up(&info->started);
+
+    asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+    NOT_REACHED();
+}
+
+/* Waits for thread TID of the running process to end.  Returns 0,
+   or -1 at once if TID is not a thread of this process that has
+   been created by process_thread_create() and not yet joined. */
+int
+process_thread_join(tid_t tid) {
+    struct thread *proc = thread_current()->proc;
+    struct uthread *ut = NULL;
+    struct list_elem *e;
+
+    lock_acquire(&proc->proc_lock);
+    for (e = list_begin(&proc->uthreads); e != list_end(&proc->uthreads);
+         e = list_next(e))
+        if (list_entry(e, struct uthread, elem)->tid == tid) {
+            ut = list_entry(e, struct uthread, elem);
+            list_remove(e);
+            break;
+        }
+    lock_release(&proc->proc_lock);
+    if (ut == NULL)
+        return -1;
+
+    sema_down(&ut->done);
+    free(ut);
+    return 0;
+}
+
+/* Ends the running user thread.  In the first thread of a
+   process, first waits for every other thread to end and then
+   exits the process with status 0. */
+void
+process_thread_exit(void) {
+    struct thread *cur = thread_current();
+
+    if (cur->proc == cur) {
+        while (!list_empty(&cur->uthreads)) {
+            struct uthread *ut = list_entry(list_front(&cur->uthreads),
+                                            struct uthread, elem);
+            process_thread_join(ut->tid);
+        }
+        exit_proc(0);
+    }
+    cur->exit_error = 0;
+    thread_exit();
+}
+
+/* Makes the running thread's process exit with STATUS.  Every
+   thread of the process, including the caller, dies the next time
+   it returns to user mode.  Has no effect if the process is
+   already exiting. */
+void
+process_kill(int status) {
+    struct thread *proc = thread_current()->proc;
+
+    lock_acquire(&proc->proc_lock);
+    if (proc->exiting) {
+        lock_release(&proc->proc_lock);
+        return;
+    }
+    proc->exit_error = status;
+    proc->exiting = true;
+    lock_release(&proc->proc_lock);
+    futex_wake_process(proc);
+}
+
+/* Called on the way back to user mode.  Ends the running thread
+   if its process is exiting. */
+void
+process_check_exit(void) {
+    struct thread *cur = thread_current();
+
+    if (!cur->proc->exiting)
+        return;
+    intr_enable();
+    if (cur->proc == cur)
+        exit_proc(cur->exit_error);
+    cur->exit_error = 0;
+    thread_exit();
+}
+
+/* Releases the stack slot of user thread CUR, which is exiting,
+   and lets the thread's joiner and process know it is gone.
+   A thread that was not ended by process_thread_exit(), such as
+   one that died of a page fault, takes its process with it. */
+static void
+uthread_exit(struct thread *cur) {
+    struct thread *proc = cur->proc;
+
+    if (cur->exit_error == -100)
+        process_kill(-1);
+
+    page_free_stack(cur->ustack_slot);
+    lock_acquire(&proc->proc_lock);
+    proc->ustack_slots &= ~(1u << cur->ustack_slot);
+    lock_release(&proc->proc_lock);
+
+    /* Stop using the address space before the first thread can
+       destroy it. */
+    cur->pagedir = NULL;
+    cur->pages = NULL;
+    pagedir_activate(NULL);
+    sema_up(&cur->uthread->done);
+}
+
+/* Makes every other thread of process PROC, which must be the
+   running thread, exit and waits for them to be gone. */
+static void
+stop_uthreads(struct thread *proc) {
+    if (list_empty(&proc->uthreads))
+        return;
+
+    lock_acquire(&proc->proc_lock);
+    proc->exiting = true;
+    lock_release(&proc->proc_lock);
+    futex_wake_process(proc);
+
+    while (!list_empty(&proc->uthreads)) {
+        struct uthread *ut = list_entry(list_front(&proc->uthreads),
+                                        struct uthread, elem);
+        process_thread_join(ut->tid);
+    }
+}
+
 /* We load ELF binaries.  The following definitions are taken
    from the ELF specification, [ELF1], more-or-less verbatim.  */
 
@@ -8,4 +8,10 @@ int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 
+tid_t process_thread_create (void *eip, void *func, void *aux);
+int process_thread_join (tid_t);
+void process_thread_exit (void) NO_RETURN;
+void process_kill (int status);
+void process_check_exit (void);
+
 #endif /* userprog/process.h */
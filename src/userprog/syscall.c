@@ -12,26 +12,49 @@
 #include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
+#include "vm/futex.h"
 #include "vm/page.h"
+#include "vm/vmstat.h"
 
 static void syscall_handler (struct intr_frame *);
 void* check_addr(const void*);
 struct proc_file* list_search(struct list* files, int fd);
+static int sys_read (int handle, void *buffer, unsigned size);
+static int sys_write (int handle, const void *buffer, unsigned size);
+static bool sys_vmstat (struct vmstat *stats, bool system);
+static bool sys_schedstat (struct schedstat *stats);
 static struct lock fs_lock;
 extern bool running;
 
+/* Object cache for struct mapping. */
+static struct slab_cache mapping_cache;
+
 struct proc_file {
     struct file* ptr;
     int fd;
     struct list_elem elem;
 };
 
+/* Binds a mapping id to a region of memory and a file. */
+struct mapping
+{
+    struct list_elem elem;      /* List element. */
+    int handle;                 /* Mapping id. */
+    struct file *file;          /* File. */
+    uint8_t *base;              /* Start of memory mapping. */
+    size_t page_cnt;            /* Number of pages mapped. */
+};
+
 void
 syscall_init (void)
 {
     intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+    slab_cache_init (&mapping_cache, "mapping", sizeof (struct mapping));
 }
 
 static void
@@ -44,6 +67,7 @@ syscall_handler (struct intr_frame *f UNUSED)
 
 
     int system_call = * p;
+    trace_point (TRACE_SYSCALL_ENTER, system_call, 0, 0);
     switch (system_call)
     {
         case SYS_HALT:
@@ -91,93 +115,58 @@ syscall_handler (struct intr_frame *f UNUSED)
 
             acquire_filesys_lock();
             struct file* fptr = filesys_open (*(p+1));
-            release_filesys_lock();
             if(fptr==NULL)
                 f->eax = -1;
             else
             {
+                /* The file list is shared by all of the process's
+                   threads, so update it under the lock too. */
                 struct proc_file *pfile = malloc(sizeof(*pfile));
                 pfile->ptr = fptr;
-                pfile->fd = thread_current()->fd_count;
-                thread_current()->fd_count++;
-                list_push_back (&thread_current()->files, &pfile->elem);
+                pfile->fd = thread_current()->proc->fd_count;
+                thread_current()->proc->fd_count++;
+                list_push_back (&thread_current()->proc->files, &pfile->elem);
                 f->eax = pfile->fd;
 
             }
+            release_filesys_lock();
             break;
 
         case SYS_FILESIZE:
             check_addr(p+1);
             acquire_filesys_lock();
-            f->eax = file_length (list_search(&thread_current()->files, *(p+1))->ptr);
+            f->eax = file_length (list_search(&thread_current()->proc->files, *(p+1))->ptr);
             release_filesys_lock();
             break;
 
         case SYS_READ:
             check_addr(p+7);
-            check_addr(*(p+6));
-            if(*(p+5)==0)
-            {
-                int i;
-                uint8_t* buffer = *(p+6);
-                for(i=0;i<*(p+7);i++)
-                    buffer[i] = input_getc();
-                f->eax = *(p+7);
-            }
-            else
-            {
-                struct proc_file* fptr = list_search(&thread_current()->files, *(p+5));
-                if(fptr==NULL)
-                    f->eax=-1;
-                else
-                {
-                    acquire_filesys_lock();
-                    f->eax = file_read (fptr->ptr, *(p+6), *(p+7));
-                    release_filesys_lock();
-                }
-            }
+            f->eax = sys_read(*(p+5), (void *) *(p+6), *(p+7));
             break;
 
         case SYS_WRITE:
             check_addr(p+7);
-            check_addr(*(p+6));
-            if(*(p+5)==1)
-            {
-                putbuf(*(p+6),*(p+7));
-                f->eax = *(p+7);
-            }
-            else
-            {
-                struct proc_file* fptr = list_search(&thread_current()->files, *(p+5));
-                if(fptr==NULL)
-                    f->eax=-1;
-                else
-                {
-                    acquire_filesys_lock();
-                    f->eax = file_write (fptr->ptr, *(p+6), *(p+7));
-                    release_filesys_lock();
-                }
-            }
+            f->eax = sys_write(*(p+5), (const void *) *(p+6), *(p+7));
             break;
 
         case SYS_SEEK:
             check_addr(p+5);
             acquire_filesys_lock();
-            file_seek(list_search(&thread_current()->files, *(p+4))->ptr,*(p+5));
+            file_seek(list_search(&thread_current()->proc->files, *(p+4))->ptr,*(p+5));
             release_filesys_lock();
             break;
 
         case SYS_TELL:
             check_addr(p+1);
             acquire_filesys_lock();
-            f->eax = file_tell(list_search(&thread_current()->files, *(p+1))->ptr);
+            f->eax = file_tell(list_search(&thread_current()->proc->files, *(p+1))->ptr);
             release_filesys_lock();
             break;
 
         case SYS_CLOSE:
             check_addr(p+1);
             acquire_filesys_lock();
-            close_file(&thread_current()->files,*(p+1));
+            close_file(&thread_current()->proc->files,*(p+1));
             release_filesys_lock();
             break;
 
@@ -196,9 +185,58 @@ syscall_handler (struct intr_frame *f UNUSED)
             release_filesys_lock();
             break;
 
+        case SYS_VMSTAT:
+            check_addr(p+2);
+            f->eax = sys_vmstat((struct vmstat *) *(p+1), *(p+2));
+            break;
+
+        case SYS_SETTICKETS:
+            check_addr(p+1);
+            f->eax = thread_set_tickets(*(p+1));
+            break;
+
+        case SYS_LOCKSTAT:
+            lock_print_stats();
+            break;
+
+        case SYS_SCHEDSTAT:
+            check_addr(p+1);
+            f->eax = sys_schedstat((struct schedstat *) *(p+1));
+            break;
+
+        case SYS_FUTEX_WAIT:
+            check_addr(p+2);
+            f->eax = futex_wait((const int *) *(p+1), *(p+2));
+            if ((int) f->eax == FUTEX_FAULT)
+                exit_proc(-1);
+            break;
+
+        case SYS_FUTEX_WAKE:
+            check_addr(p+2);
+            f->eax = futex_wake((const int *) *(p+1), *(p+2));
+            if ((int) f->eax == FUTEX_FAULT)
+                exit_proc(-1);
+            break;
+
+        case SYS_THREAD_CREATE:
+            check_addr(p+3);
+            f->eax = process_thread_create((void *) *(p+1), (void *) *(p+2),
+                                           (void *) *(p+3));
+            break;
+
+        case SYS_THREAD_JOIN:
+            check_addr(p+1);
+            f->eax = process_thread_join(*(p+1));
+            break;
+
+        case SYS_THREAD_EXIT:
+            process_thread_exit();
+            break;
+
         default:
             printf("Default %d\n",*p);
     }
+    trace_point (TRACE_SYSCALL_EXIT, system_call, f->eax, 0);
 }
 
 int exec_proc(char *file_name)
@@ -230,6 +268,14 @@ void exit_proc(int status)
     //printf("Exit : %s %d %d\n",thread_current()->name, thread_current()->tid, status);
     struct list_elem *e;
 
+    /* exit() in any thread but the first ends the whole process,
+       with the first thread reporting STATUS to the parent. */
+    if (thread_current()->proc != thread_current())
+    {
+        process_kill(status);
+        process_thread_exit();
+    }
+
     for (e = list_begin (&thread_current()->parent->child_proc); e != list_end (&thread_current()->parent->child_proc);
          e = list_next (e))
     {
@@ -266,6 +312,171 @@ void* check_addr(const void *vaddr)
     return ptr;
 }
 
+/* Kills the process unless the SIZE bytes starting at BUFFER
+   all lie in user virtual memory.  Whether the pages are present
+   is left to page_lock_range(). */
+static void
+check_buffer (const void *buffer, unsigned size)
+{
+    const uint8_t *start = buffer;
+
+    if (size == 0)
+        return;
+    if (!is_user_vaddr (start) || start + size < start
+        || !is_user_vaddr (start + size - 1))
+        exit_proc (-1);
+}
+
+/* Maximum number of user buffer pages that read and write lock
+   into memory at a time.  Bounding this keeps a huge buffer from
+   locking down every frame. */
+#define IO_PIN_PAGES 16
+
+/* Returns the number of bytes of the SIZE-byte buffer at BUFFER
+   that read and write should lock and transfer in one step. */
+static size_t
+io_chunk_size (const void *buffer, size_t size)
+{
+    size_t chunk = IO_PIN_PAGES * PGSIZE - pg_ofs (buffer);
+    return chunk < size ? chunk : size;
+}
+
+/* Read system call.
+   The user buffer is locked into memory a chunk at a time with
+   page_lock_range(), faulting in any non-resident pages, and the
+   file layer then copies straight into the locked frames.  This
+   works for buffers that have been swapped out and never takes a
+   page fault while filesys_lock is held. */
+static int
+sys_read (int handle, void *buffer, unsigned size)
+{
+    struct proc_file *fptr = NULL;
+    uint8_t *udst = buffer;
+    int bytes_read = 0;
+
+    check_buffer (buffer, size);
+    if (handle != 0)
+    {
+        fptr = list_search (&thread_current ()->proc->files, handle);
+        if (fptr == NULL)
+            return -1;
+    }
+
+    while (size > 0)
+    {
+        size_t chunk = io_chunk_size (udst, size);
+        off_t retval;
+
+        if (!page_lock_range (udst, chunk, true))
+            exit_proc (-1);
+        if (fptr == NULL)
+        {
+            size_t i;
+            for (i = 0; i < chunk; i++)
+                udst[i] = input_getc ();
+            retval = chunk;
+        }
+        else
+        {
+            acquire_filesys_lock ();
+            retval = file_read (fptr->ptr, udst, chunk);
+            release_filesys_lock ();
+        }
+        page_unlock_range (udst, chunk);
+
+        bytes_read += retval;
+        if (retval != (off_t) chunk)
+            break;
+        udst += chunk;
+        size -= chunk;
+    }
+    return bytes_read;
+}
+
+/* Write system call.
+   Locks the user buffer chunk by chunk, like sys_read(), and
+   hands the locked pages straight to the console or file layer. */
+static int
+sys_write (int handle, const void *buffer, unsigned size)
+{
+    struct proc_file *fptr = NULL;
+    const uint8_t *usrc = buffer;
+    int bytes_written = 0;
+
+    check_buffer (buffer, size);
+    if (handle != 1)
+    {
+        fptr = list_search (&thread_current ()->proc->files, handle);
+        if (fptr == NULL)
+            return -1;
+    }
+
+    while (size > 0)
+    {
+        size_t chunk = io_chunk_size (usrc, size);
+        off_t retval;
+
+        if (!page_lock_range (usrc, chunk, false))
+            exit_proc (-1);
+        if (fptr == NULL)
+        {
+            putbuf ((const char *) usrc, chunk);
+            retval = chunk;
+        }
+        else
+        {
+            acquire_filesys_lock ();
+            retval = file_write (fptr->ptr, usrc, chunk);
+            release_filesys_lock ();
+        }
+        page_unlock_range (usrc, chunk);
+
+        bytes_written += retval;
+        if (retval != (off_t) chunk)
+            break;
+        usrc += chunk;
+        size -= chunk;
+    }
+    return bytes_written;
+}
+
+/* Vmstat system call.
+   Copies the system-wide virtual memory statistics into STATS if
+   SYSTEM is true, otherwise the calling process's own. */
+static bool
+sys_vmstat (struct vmstat *stats, bool system)
+{
+    struct vmstat kstats;
+
+    check_buffer (stats, sizeof *stats);
+    vmstat_get (&kstats, system);
+    if (!page_lock_range (stats, sizeof *stats, true))
+        exit_proc (-1);
+    memcpy (stats, &kstats, sizeof *stats);
+    page_unlock_range (stats, sizeof *stats);
+    return true;
+}
+
+/* Schedstat system call.
+   Copies the system-wide scheduler latency statistics and the
+   calling thread's own counters into STATS.  Returns false if
+   the kernel was not booted with "-schedstat", which is what
+   keeps them. */
+static bool
+sys_schedstat (struct schedstat *stats)
+{
+    struct schedstat kstats;
+
+    check_buffer (stats, sizeof *stats);
+    if (!thread_get_schedstat (&kstats))
+        return false;
+    if (!page_lock_range (stats, sizeof *stats, true))
+        exit_proc (-1);
+    memcpy (stats, &kstats, sizeof *stats);
+    page_unlock_range (stats, sizeof *stats);
+    return true;
+}
+
 struct proc_file* list_search(struct list* files, int fd)
 {
 
@@ -324,23 +535,13 @@ void close_all_files(struct list* files)
 }
 
 
-/* Binds a mapping id to a region of memory and a file. */
-struct mapping
-{
-    struct list_elem elem;      /* List element. */
-    int handle;                 /* Mapping id. */
-    struct file *file;          /* File. */
-    uint8_t *base;              /* Start of memory mapping. */
-    size_t page_cnt;            /* Number of pages mapped. */
-};
-
 /* Returns the file descriptor associated with the given handle.
    Terminates the process if HANDLE is not associated with a
    memory mapping. */
 static struct mapping *
 lookup_mapping (int handle)
 {
-    struct thread *cur = thread_current ();
+    struct thread *cur = thread_current ()->proc;
     struct list_elem *e;
 
     for (e = list_begin (&cur->mappings); e != list_end (&cur->mappings);
@@ -379,6 +580,7 @@ unmap (struct mapping *m)
     {
         page_deallocate((void *) ((m->base) + (PGSIZE * i)));
     }
+    slab_free (&mapping_cache, m);
 }
 
 /* Mmap system call. */
@@ -386,25 +588,28 @@ static int
 sys_mmap (int handle, void *addr)
 {
     struct proc_file *fd = lookup_fd (handle);
-    struct mapping *m = malloc (sizeof *m);
+    struct mapping *m;
     size_t offset;
     off_t length;
 
-    if (m == NULL || addr == NULL || pg_ofs (addr) != 0)
+    if (addr == NULL || pg_ofs (addr) != 0)
+        return -1;
+    m = slab_alloc (&mapping_cache);
+    if (m == NULL)
         return -1;
 
-    m->handle = thread_current ()->next_handle++;
+    m->handle = thread_current ()->proc->next_handle++;
     lock_acquire (&fs_lock);
     m->file = file_reopen (fd->ptr);
     lock_release (&fs_lock);
     if (m->file == NULL)
     {
-        free (m);
+        slab_free (&mapping_cache, m);
         return -1;
     }
     m->base = addr;
     m->page_cnt = 0;
-    list_push_front (&thread_current ()->mappings, &m->elem);
+    list_push_front (&thread_current ()->proc->mappings, &m->elem);
 
     offset = 0;
     lock_acquire (&fs_lock);
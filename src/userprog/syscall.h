@@ -5,4 +5,6 @@ void syscall_init(void);
 
 void syscall_exit(void);
 
+void exit_proc(int status);
+
 #endif /* userprog/syscall.h */
\ No newline at end of file
@@ -1,35 +1,50 @@
 #include "vm/frame.h"
 #include <stdio.h>
 #include "vm/page.h"
+#include "vm/vmstat.h"
 #include "devices/timer.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 static struct frame *frames;
 static size_t frame_cnt;
 
+/* Kernel virtual address of frames[0].  The user pool hands out
+   its pages in ascending order at boot, so frame I lives at
+   frames_base + I * PGSIZE and the address need not be stored in
+   every frame. */
+static uint8_t *frames_base;
+
 static struct lock scan_lock;
 static size_t hand;
 
+/* Wait queues for threads sleeping on a locked frame.
+   Frames are hashed onto buckets by index.  Releasing a frame
+   wakes every thread in its bucket and each one re-checks its
+   own frame, so a collision costs a spurious wakeup, nothing
+   more. */
+#define FRAME_WAIT_BUCKETS 32
+static struct list frame_waiters[FRAME_WAIT_BUCKETS];
+
 /* Initialize the frame manager.
  * in this function it tries to add (divide) new frames to the main memory*/
 void
 frame_init(void) {
     //base address (start address) for the new frame
     void *base;
+    size_t i;
     /* Initializes scan_lock .
      * scan_lock can be held by at most a single thread so one thread is going to allocate the frames .
      * only one thread can be inside this code sector at a time */
     lock_init(&scan_lock);
-    /* malloc : obtains and returns a new block(new block means new allocated frame)
-     * of at least size (frames * init_ram_pages) bytes.
-     * Returns a null pointer if memory is not available. */
-    frames = malloc(sizeof *frames * init_ram_pages);
-    if (frames == NULL)
-        PANIC("out of memory allocating page frames");
+    lock_set_name(&scan_lock, "frame scan");
+    for (i = 0; i < FRAME_WAIT_BUCKETS; i++)
+        list_init(&frame_waiters[i]);
 /*palloc_get_page(PAL_USER): Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -41,15 +56,94 @@ frame_init(void) {
 
 //base address for the new frame != null , then it's a new frame added to the memory
     while ((base = palloc_get_page(PAL_USER)) != NULL) {
+        if (frame_cnt == 0)
+            frames_base = base;
+        /*frame_base() relies on the user pool being handed out contiguously*/
+        ASSERT(base == frames_base + frame_cnt * PGSIZE);
         //increase the size of the frames that exists in the main memory by one
-        struct frame *f = &frames[frame_cnt++];
-        /*initialize the frame lock to 1 (1 means that the lock is opened for that frame ,means it's a free  frame )*/
-        lock_init(&f->lock);
-        //base address for the frame
-        f->base = base;
-        //doesn't contain a page yet it's a free frame
-        f->page = NULL;
+        frame_cnt++;
     }
+    if (frame_cnt == 0)
+        return;
+
+    /* calloc : obtains and returns a new zeroed block of at least
+     * (frame_cnt * sizeof *frames) bytes, so every frame starts
+     * out unlocked (holder == NULL) and free (page == NULL).
+     * Returns a null pointer if memory is not available. */
+    frames = calloc(frame_cnt, sizeof *frames);
+    if (frames == NULL)
+        PANIC("out of memory allocating page frames");
+    printf("%zu frames in frame table (%zu bytes).\n",
+           frame_cnt, frame_cnt * sizeof *frames);
+}
+
+/* Returns the kernel virtual address of frame F. */
+void *
+frame_base(const struct frame *f) {
+    return frames_base + (size_t) (f - frames) * PGSIZE;
+}
+
+/* Returns true if the current thread holds F's lock, false
+   otherwise. */
+bool
+frame_held_by_current_thread(const struct frame *f) {
+    return f->holder == thread_current();
+}
+
+/* Returns the wait queue that threads sleeping on F use. */
+static struct list *
+frame_wait_queue(const struct frame *f) {
+    return &frame_waiters[(size_t) (f - frames) % FRAME_WAIT_BUCKETS];
+}
+
+/* Locks F, sleeping until it is available if necessary. */
+static void
+frame_acquire(struct frame *f) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(!intr_context());
+    ASSERT(f->holder != cur);
+
+    old_level = intr_disable();
+    while (f->holder != NULL) {
+        list_push_back(frame_wait_queue(f), &cur->elem);
+        thread_block();
+    }
+    f->holder = cur;
+    intr_set_level(old_level);
+}
+
+/* Tries to lock F without sleeping.
+   Returns true if successful, false if F is already locked. */
+static bool
+frame_try_acquire(struct frame *f) {
+    enum intr_level old_level;
+    bool success;
+
+    old_level = intr_disable();
+    success = f->holder == NULL;
+    if (success)
+        f->holder = thread_current();
+    intr_set_level(old_level);
+    return success;
+}
+
+/* Unlocks F, which the current thread must hold, and wakes up
+   the threads waiting in F's bucket. */
+static void
+frame_release(struct frame *f) {
+    struct list *waiters = frame_wait_queue(f);
+    enum intr_level old_level;
+
+    ASSERT(frame_held_by_current_thread(f));
+
+    old_level = intr_disable();
+    f->holder = NULL;
+    while (!list_empty(waiters))
+        thread_unblock(list_entry(list_pop_front(waiters),
+                                  struct thread, elem));
+    intr_set_level(old_level);
 }
 
 /* Tries to allocate and lock a frame for PAGE.
@@ -63,7 +157,7 @@ try_frame_alloc_and_lock(struct page *page) {
     /* Find a free frame. */
     for (i = 0; i < frame_cnt; i++) {
         struct frame *f = &frames[i];
-        if (!lock_try_acquire(&f->lock))
+        if (!frame_try_acquire(f))
             /*if it isn't a suitable frame for the given page go to the loop to look in the next index (look for another frame) */
             continue;
         /*the below condition means that he find the free frame
@@ -75,7 +169,7 @@ try_frame_alloc_and_lock(struct page *page) {
             return f;
         }
         /*release the lock for the current frame which is suitable for this page but it isn't free (like the clock algorithm)*/
-        lock_release(&f->lock);
+        frame_release(f);
     }
 
     /*the first loop fails to find a free frame,
@@ -84,15 +178,18 @@ try_frame_alloc_and_lock(struct page *page) {
     for (i = 0; i < frame_cnt * 2; i++) {
         /* Get a frame at index hand */
         struct frame *f = &frames[hand];
+        vmstat_add(VMSTAT_SCANS, 1);
         //if hand + 1 >= the size of the available frames in the main memory (frame_cnt)
-        if (++hand >= frame_cnt)
+        if (++hand >= frame_cnt) {
             /*make hand = 0 to search from the beginning because it might not start from the first place
              * as it starts from the last place it puts a new page in it (like the clock algorithm)*/
             hand = 0;
+            vmstat_add(VMSTAT_LAPS, 1);
+        }
 
         /*if you cann't find a suitable frame continue which means go ahead for the loop to
          * go to the next position*/
-        if (!lock_try_acquire(&f->lock))
+        if (!frame_try_acquire(f))
             continue;
 
         /*if you find a suitable frame check that it's free*/
@@ -105,7 +202,7 @@ try_frame_alloc_and_lock(struct page *page) {
         /* Returns true if page P's data has been accessed recently,false otherwise*/
         if (page_accessed_recently(f->page)) {
             /*if it's accessed recently release its lock but don't swap it from the main memory*/
-            lock_release(&f->lock);
+            frame_release(f);
             /*then continue to the loop to go to the next index*/
             continue;
         }
@@ -116,9 +213,10 @@ try_frame_alloc_and_lock(struct page *page) {
         /* Evict this frame. */
         if (!page_out(f->page)) {
             /*! : means that he fails to evict this frame so release its lock and return null*/
-            lock_release(&f->lock);
+            frame_release(f);
             return NULL;
         }
+        vmstat_add(VMSTAT_EVICTIONS, 1);
 
         /*if non of this condition happens that means we find the frame .
          * allocate the f-> page to the given page
@@ -142,7 +240,7 @@ frame_alloc_and_lock(struct page *page) {
     for (try = 0; try < 3; try++) {
         struct frame *f = try_frame_alloc_and_lock(page);
         if (f != NULL) {
-            ASSERT(lock_held_by_current_thread(&f->lock));
+            ASSERT(frame_held_by_current_thread(f));
             return f;
         }
         timer_msleep(1000);
@@ -160,10 +258,10 @@ frame_lock(struct page *p) {
     if (f != NULL) {
         /*means that the frame is allocated to a page*/
         /*lock that frame*/
-        lock_acquire(&f->lock);
+        frame_acquire(f);
         if (f != p->frame) {
             /*if it isn't p frame release it*/
-            lock_release(&f->lock);
+            frame_release(f);
             ASSERT(p->frame == NULL);
         }
     }
@@ -175,11 +273,11 @@ frame_lock(struct page *p) {
 void
 frame_free(struct frame *f) {
     /*make sure that isn't a free frame*/
-    ASSERT(lock_held_by_current_thread(&f->lock));
+    ASSERT(frame_held_by_current_thread(f));
     /*make its page = null*/
     f->page = NULL;
     /*release the frame by opening its lock*/
-    lock_release(&f->lock);
+    frame_release(f);
 }
 
 /* Unlocks frame F but not freeing it, allowing it to be evicted.
@@ -187,7 +285,7 @@ frame_free(struct frame *f) {
 void
 frame_unlock(struct frame *f) {
     /*make sure that isn't a free frame*/
-    ASSERT(lock_held_by_current_thread(&f->lock));
+    ASSERT(frame_held_by_current_thread(f));
     /*release the frame by opening its lock*/
-    lock_release(&f->lock);
+    frame_release(f);
 }
\ No newline at end of file
@@ -4,11 +4,17 @@
 #include <stdbool.h>
 #include "threads/synch.h"
 
-/* A physical frame. */
+/* A physical frame.
+   Kept as small as possible because there is one per user page
+   of RAM and the clock hand walks the whole array.  The frame's
+   kernel virtual address is not stored: it is derived from the
+   frame's index in the frame table (see frame_base()).  The
+   frame lock is the `holder' word itself: a frame is locked iff
+   `holder' is non-null, and threads waiting for a locked frame
+   sleep on a small hashed wait-queue table in frame.c. */
 struct frame {
-    struct lock lock;           /* Prevent simultaneous access. */
-    void *base;                 /* Kernel virtual base address. */
     struct page *page;          /* Mapped process page, if any. */
+    struct thread *holder;      /* Thread holding the frame lock, or null. */
 };
 
 void frame_init(void);
@@ -21,4 +27,8 @@ void frame_free(struct frame *);
 
 void frame_unlock(struct frame *);
 
-#endif /* vm/frame.h */
\ No newline at end of file
+void *frame_base(const struct frame *);
+
+bool frame_held_by_current_thread(const struct frame *);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,162 @@
+#include "vm/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "vm/page.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Futexes: wait queues for user-space synchronization.
+
+   A user-space lock or condition lives in an ordinary int in user
+   memory and is manipulated with atomic instructions, entering
+   the kernel only to sleep or to wake sleepers.  futex_wait()
+   sleeps only if the int still holds the value the caller last
+   saw, and the check and the sleep are atomic with respect to
+   futex_wake(), so a wake-up between the caller's check and its
+   sleep cannot be lost.
+
+   Waiters are keyed by the memory they wait on.  A frame may be
+   evicted and another frame used for the same page while a thread
+   sleeps, so the key is the page that owns the memory, plus the
+   offset in it, rather than the frame's address; no two pages
+   share a frame, so this identifies the same memory for every
+   thread that maps it. */
+
+/* One thread waiting in futex_wait(). */
+struct futex_waiter {
+    const struct page *page;    /* Page waited on. */
+    unsigned ofs;               /* Offset of the int in the page. */
+    struct semaphore sema;      /* Upped by futex_wake(). */
+    struct list_elem elem;      /* Element in bucket's `waiters'. */
+};
+
+/* Hash table of waiters. */
+#define FUTEX_BUCKETS 64
+static struct futex_bucket {
+    struct lock lock;           /* Protects `waiters'. */
+    struct list waiters;        /* Waiters that hash here, oldest first. */
+} buckets[FUTEX_BUCKETS];
+
+static struct futex_bucket *bucket_for(const struct page *, unsigned ofs);
+
+static bool valid_uaddr(const int *);
+
+/* Initializes the futex wait queues. */
+void
+futex_init(void) {
+    size_t i;
+
+    for (i = 0; i < FUTEX_BUCKETS; i++) {
+        lock_init(&buckets[i].lock);
+        list_init(&buckets[i].waiters);
+    }
+}
+
+/* If the int at user address UADDR equals EXPECTED, sleeps until
+   woken by futex_wake() and returns 0.  Otherwise, or if the
+   process is exiting, returns -1 at once.  Returns FUTEX_FAULT if
+   UADDR is bad. */
+int
+futex_wait(const int *uaddr, int expected) {
+    struct futex_waiter w;
+    struct futex_bucket *b;
+    int value;
+
+    if (!valid_uaddr(uaddr) || !page_lock(uaddr, false))
+        return FUTEX_FAULT;
+    w.page = page_for_addr(uaddr);
+    w.ofs = pg_ofs(uaddr);
+    b = bucket_for(w.page, w.ofs);
+
+    /* Holding the bucket lock from the check until we are queued
+       keeps futex_wake() from running in between. */
+    lock_acquire(&b->lock);
+    value = *uaddr;
+    page_unlock(uaddr);
+    if (value != expected || thread_current()->proc->exiting) {
+        lock_release(&b->lock);
+        return -1;
+    }
+    sema_init(&w.sema, 0);
+    list_push_back(&b->waiters, &w.elem);
+    lock_release(&b->lock);
+
+    sema_down(&w.sema);
+    return 0;
+}
+
+/* Wakes up to N threads waiting on the int at user address UADDR,
+   oldest first, and returns the number woken.  Returns
+   FUTEX_FAULT if UADDR is bad.  Unlike futex_wait(), never
+   allocates a page for UADDR: nobody can be waiting on a page
+   that does not exist yet. */
+int
+futex_wake(const int *uaddr, int n) {
+    const struct page *page;
+    struct futex_bucket *b;
+    struct list_elem *e;
+    unsigned ofs;
+    int woken = 0;
+
+    if (!valid_uaddr(uaddr))
+        return FUTEX_FAULT;
+    page = page_find(thread_current()->proc, pg_round_down(uaddr));
+    if (page == NULL)
+        return FUTEX_FAULT;
+    ofs = pg_ofs(uaddr);
+    b = bucket_for(page, ofs);
+
+    lock_acquire(&b->lock);
+    for (e = list_begin(&b->waiters); e != list_end(&b->waiters)
+                                      && woken < n;) {
+        struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+        if (w->page == page && w->ofs == ofs) {
+            e = list_remove(e);
+            sema_up(&w->sema);
+            woken++;
+        } else
+            e = list_next(e);
+    }
+    lock_release(&b->lock);
+    return woken;
+}
+
+/* Wakes every thread of process PROC that waits in futex_wait(),
+   so that the threads of a dying process all get to die. */
+void
+futex_wake_process(const struct thread *proc) {
+    size_t i;
+
+    for (i = 0; i < FUTEX_BUCKETS; i++) {
+        struct futex_bucket *b = &buckets[i];
+        struct list_elem *e;
+
+        lock_acquire(&b->lock);
+        for (e = list_begin(&b->waiters); e != list_end(&b->waiters);) {
+            struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+            if (w->page->thread == proc) {
+                e = list_remove(e);
+                sema_up(&w->sema);
+            } else
+                e = list_next(e);
+        }
+        lock_release(&b->lock);
+    }
+}
+
+/* Returns the bucket for the int at offset OFS in PAGE. */
+static struct futex_bucket *
+bucket_for(const struct page *page, unsigned ofs) {
+    uintptr_t key = (uintptr_t) page ^ ofs;
+    return &buckets[hash_int(key) % FUTEX_BUCKETS];
+}
+
+/* Returns true if UADDR is a properly aligned user address. */
+static bool
+valid_uaddr(const int *uaddr) {
+    return uaddr != NULL && is_user_vaddr(uaddr)
+           && (uintptr_t) uaddr % sizeof *uaddr == 0;
+}
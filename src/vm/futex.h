@@ -0,0 +1,18 @@
+#ifndef VM_FUTEX_H
+#define VM_FUTEX_H
+
+/* Returned by futex_wait() and futex_wake() for an address that
+   is not a valid, aligned user address. */
+#define FUTEX_FAULT (-2)
+
+struct thread;
+
+void futex_init(void);
+
+int futex_wait(const int *uaddr, int expected);
+
+int futex_wake(const int *uaddr, int n);
+
+void futex_wake_process(const struct thread *proc);
+
+#endif /* vm/futex.h */
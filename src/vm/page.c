@@ -3,8 +3,10 @@
 #include <string.h>
 #include "vm/frame.h"
 #include "vm/swap.h"
+#include "vm/vmstat.h"
 #include "filesys/file.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/tsc.h"
 #include "threads/thread.h"
 #include "userprog/pagedir.h"
 #include "threads/vaddr.h"
@@ -13,6 +15,23 @@
 /* Right now it is 1 megabyte. */
 #define STACK_MAX (1024 * 1024)
 
+/* Maximum size of the stack of each additional user thread of a
+   process, in bytes.  Stack slot 0 is the process stack at the
+   top of user memory; slot N > 0 ends this far below slot N - 1's
+   lowest address, so the slots never overlap. */
+#define THREAD_STACK_MAX (256 * 1024)
+
+/* Object cache for struct page.
+   Every virtual page of every process has one, so they are
+   allocated and freed at a high rate on exec and mmap. */
+static struct slab_cache page_cache;
+
+/* Initializes the supplemental page table allocator. */
+void
+page_init(void) {
+    slab_cache_init(&page_cache, "page", sizeof(struct page));
+}
+
 /* Destroys a page, which must be in the current process's
    page table.*/
 static void
@@ -28,37 +47,118 @@ destroy_page(struct hash_elem *p_, void *aux UNUSED) {
     if (p->frame)
         /*if p has a frame free it*/
         frame_free(p->frame);
-    /*free the page which means make it equals to null*/
-    free(p);
+    /*give the page back to the page cache*/
+    slab_free(&page_cache, p);
 }
 
 /* Destroys the current process's page table. */
 void
 page_exit(void) {
     /*take all the pages for the current thread , put it in a hash*/
-    struct hash *h = thread_current()->pages;
+    struct thread *t = thread_current()->proc;
+    struct hash *h = t->pages;
+    /*forget the cached lookups, they are about to dangle*/
+    memset(t->page_lookup, 0, sizeof t->page_lookup);
     if (h != NULL)
         /*means the pages are loaded successfully in the hash table*/
         /*call destroy_page function each time you destroy a page in the hash table*/
         hash_destroy(h, destroy_page);
 }
 
+/* Returns the slot of T's lookup cache that user page UPAGE maps to. */
+static struct page **
+page_lookup_slot(struct thread *t, const void *upage) {
+    return &t->page_lookup[pg_no(upage) % PAGE_LOOKUP_CNT];
+}
+
+/* Returns the highest user address of stack slot SLOT, plus one.
+   Slot 0 holds the stack of a process's first thread, and each
+   further thread of the process gets a slot of its own. */
+void *
+page_stack_top(int slot) {
+    ASSERT(slot >= 0 && slot < PAGE_STACK_SLOTS);
+    if (slot == 0)
+        return PHYS_BASE;
+    return (uint8_t *) PHYS_BASE - STACK_MAX - (slot - 1) * THREAD_STACK_MAX;
+}
+
+/* Returns true if user page UPAGE lies in the stack slot of the
+   running thread. */
+static bool
+in_stack_slot(const void *upage) {
+    int slot = thread_current()->ustack_slot;
+    const uint8_t *top = page_stack_top(slot);
+    size_t max = slot == 0 ? STACK_MAX : THREAD_STACK_MAX;
+
+    return (const uint8_t *) upage > top - max && (const uint8_t *) upage < top;
+}
+
+/* Returns process T's page for user page UPAGE, or a null pointer
+   if there is none.  Unlike page_for_addr(), never allocates. */
+struct page *
+page_find(struct thread *t, void *upage) {
+    struct page **slot;
+    struct page *found;
+    struct page p;
+
+    /* The fault and syscall paths look up the same few pages
+       over and over (page_lock() then page_unlock() for every
+       page of a buffer), so try the small direct-mapped cache
+       of recent lookups before the hash table.  Entries are
+       dropped by page_deallocate() and page_exit().  The cache
+       and the table are shared by all of the process's threads,
+       any of which may deallocate a page, so both are only
+       touched under `proc_lock'. */
+    p.addr = upage;
+    slot = page_lookup_slot(t, p.addr);
+    lock_acquire(&t->proc_lock);
+    found = *slot;
+    if (found == NULL || found->addr != p.addr) {
+        struct hash_elem *e = hash_find(t->pages, &p.hash_elem);
+        found = e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
+        if (found != NULL)
+            *slot = found;
+    }
+    lock_release(&t->proc_lock);
+    return found;
+}
+
+/* Maps page P, which must have a locked frame, into its process's
+   page directory.  The directory is shared by all of the
+   process's threads, and installing a new page table may block
+   in the page allocator between finding the directory entry
+   empty and filling it, so updates are serialized by
+   `proc_lock'.  Returns true if successful, false if memory
+   allocation failed. */
+static bool
+page_map(struct page *p) {
+    struct thread *t = p->thread;
+    bool success;
+
+    ASSERT(frame_held_by_current_thread(p->frame));
+
+    lock_acquire(&t->proc_lock);
+    success = pagedir_set_page(t->pagedir, p->addr, frame_base(p->frame),
+                               !p->read_only);
+    lock_release(&t->proc_lock);
+    return success;
+}
+
 /* Returns the page containing the given virtual ADDRESS,
    or a null pointer if no such page exists.
    Allocates stack pages as necessary. */
-static struct page *
+struct page *
 page_for_addr(const void *address) {
     /*the address is smaller than the physical address base */
     if (address < PHYS_BASE) {
+        struct thread *t = thread_current();
         struct page p;
-        struct hash_elem *e;
+        struct page *found;
 
-        /* Find existing page. */
         p.addr = (void *) pg_round_down(address);   /* Round down to nearest page boundary. */
-        e = hash_find(thread_current()->pages, &p.hash_elem);
-        if (e != NULL)
-            return hash_entry(e,
-        struct page, hash_elem);
+        found = page_find(t->proc, p.addr);
+        if (found != NULL)
+            return found;
 
         /* -We need to determine if the program is attempting to access the stack.
            -First condition,makes sure that the address is not beyond the bounds of the stack space (1 MB in this
@@ -66,7 +166,7 @@ page_for_addr(const void *address) {
            -Second condition :As long as the user is attempting to access an address within 32 bytes (determined by the space
             needed for a PUSHA command) of the stack pointers, we assume that the address is valid.
             In that case, we should allocate one more stack page accordingly.*/
-        if ((p.addr > PHYS_BASE - STACK_MAX) && ((void *) thread_current()->user_esp - 32 < address)) {
+        if (in_stack_slot(p.addr) && ((void *) t->user_esp - 32 < address)) {
             return page_allocate(p.addr, false);/*add a map for the page in the page table,false means it isn't a read only page*/
         }
     }
@@ -89,22 +189,24 @@ do_page_in(struct page *p) {
         /* swap in -> put the page in main memory */
         swap_in(p);
     } else if (p->file != NULL) {
+        vmstat_add(VMSTAT_FILE_READS, 1);
         /* Get data from file to be written to the memory*/
         /* file_read_at () :
-         * Reads SIZE bytes(p->file_bytes) from FILE (p->file)into BUFFER (p->frame->base),
+         * Reads SIZE bytes(p->file_bytes) from FILE (p->file)into BUFFER (frame_base(p->frame)),
          *  starting at offset FILE_OFS (p->file_offset) in the file.
          *  Returns the number of bytes actually read,
          *  which may be less than SIZE if end of file is reached.
          *  The file's current position is unaffected. */
-        off_t read_bytes = file_read_at(p->file, p->frame->base,p->file_bytes, p->file_offset);
+        off_t read_bytes = file_read_at(p->file, frame_base(p->frame),p->file_bytes, p->file_offset);
         /*the size of the zero bytes in the swapped page is :*/
         off_t zero_bytes = PGSIZE - read_bytes;
-        memset(p->frame->base + read_bytes, 0, zero_bytes);/*fill the rest of the page with zeros*/
+        memset(frame_base(p->frame) + read_bytes, 0, zero_bytes);/*fill the rest of the page with zeros*/
         if (read_bytes != p->file_bytes) /*error:the bytes that are read != the actual bytes that we have to transfer*/
             printf("bytes read (%"PROTd") != bytes requested (%"PROTd")\n",read_bytes, p->file_bytes);
     } else {
         /* Provide all-zero page. */
-        memset(p->frame->base, 0, PGSIZE);
+        memset(frame_base(p->frame), 0, PGSIZE);
+        vmstat_add(VMSTAT_ZERO_FILLS, 1);
     }
     return true;
 }
@@ -115,39 +217,46 @@ do_page_in(struct page *p) {
 bool
 page_in(void *fault_addr) {
     struct page *p;
-    bool success;
+    bool success = false;
+    uint64_t start = rdtsc();
 
     /* Can't handle page faults*/
     if (thread_current()->pages == NULL)
-        return false;
+        goto done;
 
     p = page_for_addr(fault_addr);/*the address for the page that mad the page fault*/
     if (p == NULL)
-        return false;
+        goto done;
 
     frame_lock(p);/*lock a frame for that page in the main memory to load it in*/
     if (p->frame == NULL) {
+        /*a major fault has to read the page from swap or from its file*/
+        bool major = p->sector != (block_sector_t) - 1 || p->file != NULL;
+        vmstat_add(major ? VMSTAT_MAJOR_FAULTS : VMSTAT_MINOR_FAULTS, 1);
         /*we couldn't find a frame for the page*/
         if (!do_page_in(p))/*we couldn't lock a frame for the page*/
-            return false;
-    }
+            goto done;
+    } else
+        vmstat_add(VMSTAT_MINOR_FAULTS, 1);
     /*check if the current thread has a lock on a frame for that page .
      * means that we find a free frame for the page*/
-    ASSERT(lock_held_by_current_thread(&p->frame->lock));
+    ASSERT(frame_held_by_current_thread(p->frame));
 
     /* adding a map for a page directory into page table. */
     /* Adds a mapping in page directory (thread_current()->pagedir)
      * from user virtual page (p->addr)
-     * to the physical frame identified by kernel virtual address (p->frame->base).
+     * to the physical frame identified by kernel virtual address (frame_base(p->frame)).
      *If WRITABLE is true, the new page is read/write;
      *otherwise it is read-only.
      *Returns true if successful, false if memory allocation failed. */
-    success = pagedir_set_page(thread_current()->pagedir, p->addr,
-                               p->frame->base, !p->read_only);
+    success = page_map(p);
 
     /* Release frame. */
     frame_unlock(p->frame);
 
+    done:
+    /* Every fault counts, including those that fail. */
+    vmstat_add(VMSTAT_PAGE_IN_CYCLES, rdtsc() - start);
     return success;
 }
 
@@ -162,7 +271,7 @@ page_out(struct page *p) {
     /*make sure that page p has a frame in main memory*/
     ASSERT(p->frame != NULL);
     /*make sure that the frame is locked*/
-    ASSERT(lock_held_by_current_thread(&p->frame->lock));
+    ASSERT(frame_held_by_current_thread(p->frame));
 
     /* Mark page not present in page table,
      *forcing accesses by the process to fault.
@@ -193,7 +302,8 @@ page_out(struct page *p) {
             if (p->write_back) {
                 ok = swap_out(p);
             } else {
-                ok = file_write_at(p->file, (const void *) p->frame->base, p->file_bytes, p->file_offset);
+                ok = file_write_at(p->file, (const void *) frame_base(p->frame), p->file_bytes, p->file_offset);
+                vmstat_add(VMSTAT_FILE_WRITES, 1);
             }
         }
     }
@@ -215,7 +325,7 @@ page_accessed_recently(struct page *p) {
     /*make sure that the page has a frame in the main memory*/
     ASSERT(p->frame != NULL);
     /*and the frame is lock by the current thread*/
-    ASSERT(lock_held_by_current_thread(&p->frame->lock));
+    ASSERT(frame_held_by_current_thread(p->frame));
 
     was_accessed = pagedir_is_accessed(p->thread->pagedir, p->addr);
     if (was_accessed)
@@ -228,10 +338,10 @@ page_accessed_recently(struct page *p) {
  * Fails if VADDR is already mapped or if memory allocation fails. */
 struct page *
 page_allocate(void *vaddr, bool read_only) {
-    struct thread *t = thread_current();
-    /* Obtains and returns a new block of at least SIZE of (p) bytes.
+    struct thread *t = thread_current()->proc;
+    /* Obtains and returns a new struct page from the page cache.
    Returns a null pointer if memory is not available. */
-    struct page *p = malloc(sizeof *p);
+    struct page *p = slab_alloc(&page_cache);
     if (p != NULL) {
         p->addr = pg_round_down(vaddr);/* Round down to nearest page boundary. */
         p->read_only = read_only;
@@ -241,13 +351,15 @@ page_allocate(void *vaddr, bool read_only) {
         p->file = NULL;
         p->file_offset = 0;
         p->file_bytes = 0;
-        p->thread = thread_current();
+        p->thread = t;
 
+        lock_acquire(&t->proc_lock);
         if (hash_insert(t->pages, &p->hash_elem) != NULL) {
             /* Already mapped. */
-            free(p);/* Frees block P, which must have been previously allocated with malloc()*/
+            slab_free(&page_cache, p);/* Gives P back to the page cache*/
             p = NULL;
         }
+        lock_release(&t->proc_lock);
     }
     return p;
 }
@@ -266,8 +378,32 @@ page_deallocate(void *vaddr) {
             page_out(p);
         frame_free(f);
     }
-    hash_delete(thread_current()->pages, &p->hash_elem);
-    free(p);
+    struct thread *t = thread_current()->proc;
+    lock_acquire(&t->proc_lock);
+    hash_delete(t->pages, &p->hash_elem);
+    /*drop P from the lookup cache before it is freed*/
+    struct page **slot = page_lookup_slot(t, p->addr);
+    if (*slot == p)
+        *slot = NULL;
+    lock_release(&t->proc_lock);
+    slab_free(&page_cache, p);
+}
+
+/* Removes every page of stack slot SLOT from the running
+   thread's process, so that the next thread to use the slot
+   starts with an empty stack. */
+void
+page_free_stack(int slot) {
+    struct thread *t = thread_current()->proc;
+    uint8_t *top = page_stack_top(slot);
+    uint8_t *upage;
+
+    ASSERT(slot > 0);
+    for (upage = top - THREAD_STACK_MAX; upage < top; upage += PGSIZE)
+        if (page_find(t, upage) != NULL) {
+            pagedir_clear_page(t->pagedir, upage);
+            page_deallocate(upage);
+        }
 }
 
 /* Returns a hash value for the page that E refers to. */
@@ -305,7 +441,7 @@ page_lock(const void *addr, bool will_write) {
         /*if the page frame is null
          * means that the page doesn't have a lock frame in the memory
          * so try to add one for it and if succeed return true*/
-        return (do_page_in(p)&& pagedir_set_page(thread_current()->pagedir, p->addr,p->frame->base, !p->read_only));
+        return do_page_in(p) && page_map(p);
     else
         return true;
 }
@@ -316,4 +452,42 @@ page_unlock(const void *addr) {
     struct page *p = page_for_addr(addr);
     ASSERT(p != NULL);
     frame_unlock(p->frame);
-}
\ No newline at end of file
+}
+
+/* Locks every page of the SIZE-byte user buffer starting at ADDR
+   into physical memory, faulting in pages that are not resident,
+   so that the kernel can access the buffer without page faults.
+   If WILL_WRITE is true, the pages must be writeable.
+   Returns true if successful.  On failure no page of the buffer
+   is left locked. */
+bool
+page_lock_range(const void *addr, size_t size, bool will_write) {
+    const uint8_t *start = pg_round_down(addr);
+    const uint8_t *end = (const uint8_t *) addr + size;
+    const uint8_t *upage;
+
+    if (size == 0)
+        return true;
+    if (end < (const uint8_t *) addr)
+        return false;
+
+    for (upage = start; upage < end; upage += PGSIZE)
+        if (!page_lock(upage, will_write)) {
+            /*undo the pages locked so far*/
+            if (upage > start)
+                page_unlock_range(start, upage - start);
+            return false;
+        }
+    return true;
+}
+
+/* Unlocks the SIZE-byte user buffer starting at ADDR, which must
+   have been locked with page_lock_range(). */
+void
+page_unlock_range(const void *addr, size_t size) {
+    const uint8_t *end = (const uint8_t *) addr + size;
+    const uint8_t *upage;
+
+    for (upage = pg_round_down(addr); upage < end; upage += PGSIZE)
+        page_unlock(upage);
+}
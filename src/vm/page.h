@@ -31,10 +31,24 @@ struct page {
     off_t file_bytes;           /* Bytes to read/write, 1...PGSIZE. */
 };
 
+void page_init(void);
+
 void page_exit(void);
 
 struct page *page_allocate(void *, bool read_only);
 
+struct page *page_for_addr(const void *);
+
+struct page *page_find(struct thread *, void *upage);
+
+/* Number of user stack slots, that is, the most threads a process
+   may have. */
+#define PAGE_STACK_SLOTS 32
+
+void *page_stack_top(int slot);
+
+void page_free_stack(int slot);
+
 void page_deallocate(void *vaddr);
 
 bool page_in(void *fault_addr);
@@ -47,6 +61,10 @@ bool page_lock(const void *, bool will_write);
 
 void page_unlock(const void *);
 
+bool page_lock_range(const void *, size_t, bool will_write);
+
+void page_unlock_range(const void *, size_t);
+
 hash_hash_func page_hash;
 hash_less_func page_less;
 
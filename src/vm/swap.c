@@ -4,7 +4,9 @@
 #include <stdio.h>
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/vmstat.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 
 /* The swap device. */
@@ -35,6 +37,7 @@ swap_init(void) {
     if (swap_bitmap == NULL)
         PANIC("couldn't create swap bitmap");
     lock_init(&swap_lock);
+    lock_set_name(&swap_lock, "swap");
 }
 
 /* Swaps in page P which means put page p in main memory
@@ -48,22 +51,25 @@ swap_in(struct page *p) {
     ASSERT(p->frame != NULL);
     /*make sure that this frame is locked by the current thread
      * which is the thread that is going to move the page sectors in the main memory*/
-    ASSERT(lock_held_by_current_thread(&p->frame->lock));
+    ASSERT(frame_held_by_current_thread(p->frame));
     //check that this sector hasn't been moved before in the main memory
     ASSERT(p->sector != (block_sector_t) - 1);
 
+    trace_point(TRACE_SWAP_IN_ENTER, p->sector, 0, 0);
     for (i = 0; i < PAGE_SECTORS; i++) {
         /*read the block (page) sector by sector and put it in the buffer
            to write it in the allocated frame for that page in the main memory
            */
         block_read(swap_device, p->sector + i,
-                   p->frame->base + i * BLOCK_SECTOR_SIZE);
+                   frame_base(p->frame) + i * BLOCK_SECTOR_SIZE);
     }
     /*reset(make it equal to false) the sector that has been moved to the main memory*/
     bitmap_reset(swap_bitmap, p->sector / PAGE_SECTORS);
     /*after moving one sector from page p to the main memory
      * decrease the number of sectors for this page by 1*/
+    trace_point(TRACE_SWAP_IN_EXIT, p->sector, 0, 0);
     p->sector = (block_sector_t) - 1;
+    vmstat_add(VMSTAT_SWAP_INS, 1);
 }
 
 /* Swaps out page P, which must have a locked frame. */
@@ -76,8 +82,9 @@ swap_out(struct page *p) {
     ASSERT(p->frame != NULL);
     /*make sure that this frame is locked by the current thread
      * which is the thread that is going to move the page sectors in the main memory*/
-    ASSERT(lock_held_by_current_thread(&p->frame->lock));
+    ASSERT(frame_held_by_current_thread(p->frame));
 
+    trace_point(TRACE_SWAP_OUT_ENTER, 0, 0, 0);
     lock_acquire(&swap_lock);
     /*finds the first group of bits in the swap_bitmap
      * which their values are false and set them to true*/
@@ -93,23 +100,27 @@ swap_out(struct page *p) {
     bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)*/
     slot = bitmap_scan_and_flip(swap_bitmap, 0, 1, false);
     lock_release(&swap_lock);
-    if (slot == BITMAP_ERROR)
+    if (slot == BITMAP_ERROR) {
         //there is no group of bits starts with value = false
+        trace_point(TRACE_SWAP_OUT_EXIT, -1, 0, 0);
         return false;
+    }
 
     p->sector = slot * PAGE_SECTORS;
 
     /*  Write out page sectors for each modified block. */
     for (i = 0; i < PAGE_SECTORS; i++) {
-        //write the sector (p->sector + i) to the swap_device block from the buffer (p->frame->base + i * BLOCK_SECTOR_SIZE)
+        //write the sector (p->sector + i) to the swap_device block from the buffer (frame_base(p->frame) + i * BLOCK_SECTOR_SIZE)
         block_write(swap_device, p->sector + i,
-                    (uint8_t *) p->frame->base + i * BLOCK_SECTOR_SIZE);
+                    (uint8_t *) frame_base(p->frame) + i * BLOCK_SECTOR_SIZE);
     }
 
     p->write_back = false; /* don't write back to file*/
     p->file = NULL;
     p->file_offset = 0;
     p->file_bytes = 0;/*Bytes to read/write = 0*/
+    vmstat_add(VMSTAT_SWAP_OUTS, 1);
+    trace_point(TRACE_SWAP_OUT_EXIT, slot * PAGE_SECTORS, 0, 0);
 
     return true;
 }
\ No newline at end of file
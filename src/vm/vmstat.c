@@ -0,0 +1,55 @@
+#include "vm/vmstat.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* System-wide virtual memory statistics.
+   Each thread also keeps its own copy in struct thread, so a
+   process can see what it did to the pager and the pager can be
+   tuned from the totals. */
+static struct vmstat vm_stats;
+
+/* Adds N to counter ITEM, both system-wide and for the running
+   thread. */
+void
+vmstat_add(enum vmstat_item item, uint64_t n) {
+    enum intr_level old_level;
+
+    ASSERT(item < VMSTAT_CNT);
+
+    /* 64-bit increments are not atomic on this CPU. */
+    old_level = intr_disable();
+    vm_stats.count[item] += n;
+    thread_current()->vmstat.count[item] += n;
+    intr_set_level(old_level);
+}
+
+/* Copies the system-wide counters into STATS if SYSTEM is true,
+   otherwise the running thread's counters. */
+void
+vmstat_get(struct vmstat *stats, bool system) {
+    enum intr_level old_level = intr_disable();
+    *stats = system ? vm_stats : thread_current()->vmstat;
+    intr_set_level(old_level);
+}
+
+/* Prints the system-wide virtual memory statistics. */
+void
+vmstat_print_stats(void) {
+    const uint64_t *c = vm_stats.count;
+
+    printf("VM: %"PRIu64" minor faults, %"PRIu64" major faults, "
+           "%"PRIu64" zero-fills, %"PRIu64" file reads, "
+           "%"PRIu64" swap-ins\n",
+           c[VMSTAT_MINOR_FAULTS], c[VMSTAT_MAJOR_FAULTS],
+           c[VMSTAT_ZERO_FILLS], c[VMSTAT_FILE_READS], c[VMSTAT_SWAP_INS]);
+    printf("VM: %"PRIu64" swap-outs, %"PRIu64" file write-backs, "
+           "%"PRIu64" evictions, %"PRIu64" frames scanned, "
+           "%"PRIu64" clock laps\n",
+           c[VMSTAT_SWAP_OUTS], c[VMSTAT_FILE_WRITES], c[VMSTAT_EVICTIONS],
+           c[VMSTAT_SCANS], c[VMSTAT_LAPS]);
+    printf("VM: %"PRIu64" cycles in page_in()\n",
+           c[VMSTAT_PAGE_IN_CYCLES]);
+}
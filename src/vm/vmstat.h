@@ -0,0 +1,14 @@
+#ifndef VM_VMSTAT_H
+#define VM_VMSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vmstat.h>
+
+void vmstat_add(enum vmstat_item, uint64_t);
+
+void vmstat_get(struct vmstat *, bool system);
+
+void vmstat_print_stats(void);
+
+#endif /* vm/vmstat.h */